@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_BENCHMARK_BENCHMARK_H_
+#define CLI_BENCHMARK_BENCHMARK_H_
+
+// A minimal benchmark harness, so that the benchmarks don't need
+// any library besides the standard one.
+//
+// Each benchmark is a function executing one operation. The harness runs it
+// in batches large enough to last at least --min-time milliseconds,
+// takes the time per operation of --repetitions batches and reports
+// the median and the minimum, as text (default), json or csv.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// Prevents the compiler from optimizing away the computation of value
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct Result
+{
+    std::string name;
+    std::size_t iterations; // per batch
+    double median; // ns per operation
+    double min; // ns per operation
+};
+
+class Runner
+{
+public:
+    Runner(int argc, char* argv[])
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (Option(arg, "--format=", format)) continue;
+            if (Option(arg, "--filter=", filter)) continue;
+            std::string value;
+            if (Option(arg, "--min-time=", value)) { minTime = std::chrono::milliseconds(std::atoi(value.c_str())); continue; }
+            if (Option(arg, "--repetitions=", value)) { repetitions = std::max(1, std::atoi(value.c_str())); continue; }
+            std::cerr << "usage: " << argv[0]
+                      << " [--format=text|json|csv] [--filter=substring]"
+                         " [--min-time=milliseconds] [--repetitions=n]\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    // Measures op (a callable without parameters), if its name matches the filter
+    template <typename F>
+    void Run(const std::string& name, F op)
+    {
+        if (name.find(filter) == std::string::npos)
+            return;
+
+        // grows the batch until it lasts at least minTime
+        std::size_t iterations = 1;
+        for (;;)
+        {
+            const auto elapsed = Batch(op, iterations);
+            if (elapsed >= minTime)
+                break;
+            const auto ns = std::max<long long>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            const auto target = std::chrono::duration_cast<std::chrono::nanoseconds>(minTime).count() * 12 / 10;
+            iterations = std::max(iterations * 2, static_cast<std::size_t>(static_cast<double>(iterations) * static_cast<double>(target) / static_cast<double>(ns)));
+        }
+
+        std::vector<double> samples;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(Batch(op, iterations));
+            samples.push_back(elapsed.count() / static_cast<double>(iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+        results.push_back(Result{ name, iterations, samples[samples.size()/2], samples.front() });
+
+        if (format == "text")
+            std::cout << std::left << std::setw(48) << name << std::right
+                      << std::setw(14) << std::fixed << std::setprecision(1) << results.back().median << " ns"
+                      << std::setw(14) << iterations << " iterations" << std::endl;
+    }
+
+    // Prints the results in the format requested (the text is printed while running).
+    // Returns the exit code of the program.
+    int Report() const
+    {
+        if (format == "json")
+        {
+            std::cout << "{\n  \"benchmarks\": [\n";
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                const auto& r = results[i];
+                std::cout << "    { \"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                          << ", \"ns_per_op\": " << r.median << ", \"min_ns_per_op\": " << r.min << " }"
+                          << (i+1 < results.size() ? ",\n" : "\n");
+            }
+            std::cout << "  ]\n}\n";
+        }
+        else if (format == "csv")
+        {
+            std::cout << "name,iterations,ns_per_op,min_ns_per_op\n";
+            for (const auto& r: results)
+                std::cout << r.name << ',' << r.iterations << ',' << r.median << ',' << r.min << '\n';
+        }
+        else if (format != "text")
+        {
+            std::cerr << "unknown format " << format << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <typename F>
+    static Clock::duration Batch(F& op, std::size_t iterations)
+    {
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+            op();
+        return Clock::now() - start;
+    }
+
+    static bool Option(const std::string& arg, const std::string& option, std::string& value)
+    {
+        if (arg.compare(0, option.size(), option) != 0)
+            return false;
+        value = arg.substr(option.size());
+        return true;
+    }
+
+    std::string format = "text";
+    std::string filter;
+    std::chrono::milliseconds minTime{ 100 };
+    int repetitions = 5;
+    std::vector<Result> results;
+};
+
+} // namespace bench
+
+#endif // CLI_BENCHMARK_BENCHMARK_H_
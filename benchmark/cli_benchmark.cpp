@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+// Benchmarks of the paths executed for each line (or key) typed by the user.
+// Run with --format=json or --format=csv to track the results over time.
+
+#include <cli/cli.h>
+#include <cli/detail/commonprefix.h>
+#include <cli/detail/fromstring.h>
+#include <cli/detail/split.h>
+#include "benchmark.h"
+
+using namespace cli;
+
+namespace
+{
+
+// an ostream discarding its output
+class NullBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+NullBuffer nullBuffer;
+std::ostream nullStream(&nullBuffer);
+
+// a root menu with n commands taking an int, and a submenu with n commands
+std::unique_ptr<Menu> MakeMenu(std::size_t n)
+{
+    auto root = std::make_unique<Menu>("cli");
+    auto sub = std::make_unique<Menu>("sub");
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const auto name = "cmd" + std::to_string(i);
+        root->Insert(name, [](std::ostream& out, int x){ bench::DoNotOptimize(out); bench::DoNotOptimize(x); }, "a command");
+        sub->Insert(name, [](std::ostream& out, int x){ bench::DoNotOptimize(out); bench::DoNotOptimize(x); }, "a command");
+    }
+    root->Insert(std::move(sub));
+    return root;
+}
+
+void Split(bench::Runner& runner)
+{
+    std::vector<std::string> tokens;
+    const std::string simple = "set speed 100";
+    runner.Run("split/simple", [&]{ detail::split(tokens, simple); bench::DoNotOptimize(tokens); });
+    const std::string quoted = "insert \"a quoted sentence\" 'with \\'escapes\\'' and some more words";
+    runner.Run("split/quoted", [&]{ detail::split(tokens, quoted); bench::DoNotOptimize(tokens); });
+}
+
+void Feed(bench::Runner& runner)
+{
+    for (std::size_t n: { 10, 100, 1000 })
+    {
+        Cli cli(MakeMenu(n));
+        CliSession session(cli, nullStream);
+        const std::string last = "cmd" + std::to_string(n-1) + " 42";
+        runner.Run("feed/" + std::to_string(n) + "/command", [&]{ session.Feed(last); });
+        const std::string nested = "sub cmd" + std::to_string(n-1) + " 42";
+        runner.Run("feed/" + std::to_string(n) + "/submenu_command", [&]{ session.Feed(nested); });
+        const std::string wrong = "cmd" + std::to_string(n-1) + " notanumber";
+        runner.Run("feed/" + std::to_string(n) + "/wrong_parameter", [&]{ session.Feed(wrong); });
+    }
+
+    Cli cli(MakeMenu(1000));
+    cli.EnableStats();
+    CliSession session(cli, nullStream);
+    runner.Run("feed/1000/command_with_stats", [&]{ session.Feed("sub cmd999 42"); });
+}
+
+void Completions(bench::Runner& runner)
+{
+    for (std::size_t n: { 10, 100, 1000 })
+    {
+        Cli cli(MakeMenu(n));
+        CliSession session(cli, nullStream);
+        const auto prefix = "completions/" + std::to_string(n);
+        runner.Run(prefix + "/empty", [&]{ bench::DoNotOptimize(session.GetCompletions("")); });
+        runner.Run(prefix + "/one_match", [&]{ bench::DoNotOptimize(session.GetCompletions("cmd1 ")); });
+        runner.Run(prefix + "/some_matches", [&]{ bench::DoNotOptimize(session.GetCompletions("cmd9")); });
+        runner.Run(prefix + "/submenu", [&]{ bench::DoNotOptimize(session.GetCompletions("sub cmd9")); });
+        runner.Run(prefix + "/no_match", [&]{ bench::DoNotOptimize(session.GetCompletions("xyz")); });
+    }
+}
+
+template <typename T>
+void FromString(bench::Runner& runner, const std::string& input)
+{
+    runner.Run(std::string("from_string/") + TypeDesc<T>::Name(), [&]{ bench::DoNotOptimize(detail::from_string<T>(input)); });
+}
+
+void FromString(bench::Runner& runner)
+{
+    FromString<char>(runner, "x");
+    FromString<unsigned char>(runner, "200");
+    FromString<signed char>(runner, "-100");
+    FromString<short>(runner, "-12345");
+    FromString<unsigned short>(runner, "54321");
+    FromString<int>(runner, "-123456789");
+    FromString<unsigned int>(runner, "3456789012");
+    FromString<long>(runner, "-123456789");
+    FromString<unsigned long>(runner, "3456789012");
+    FromString<long long>(runner, "-1234567890123456789");
+    FromString<unsigned long long>(runner, "12345678901234567890");
+    FromString<float>(runner, "3.14159");
+    FromString<double>(runner, "-2.718281828459045");
+    FromString<long double>(runner, "1.5e300");
+    FromString<bool>(runner, "true");
+    FromString<std::string>(runner, "a string parameter");
+}
+
+void CommonPrefix(bench::Runner& runner)
+{
+    std::vector<std::string> completions;
+    for (std::size_t i = 0; i < 100; ++i)
+        completions.push_back("interface ethernet" + std::to_string(i));
+    runner.Run("common_prefix/100", [&]{ bench::DoNotOptimize(detail::CommonPrefix(completions)); });
+    const std::vector<std::string> two = { "show interfaces", "show interrupts" };
+    runner.Run("common_prefix/2", [&]{ bench::DoNotOptimize(detail::CommonPrefix(two)); });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::Runner runner(argc, argv);
+    Split(runner);
+    Feed(runner);
+    Completions(runner);
+    FromString(runner);
+    CommonPrefix(runner);
+    return runner.Report();
+}
@@ -0,0 +1,566 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+// A load generator for the telnet server.
+//
+// It opens a number of telnet connections, waits for the first prompt on all
+// of them and then sends the commands of a script, in a loop, for the time
+// requested. The commands are paced to reach the requested rate (as fast as
+// possible if the rate is 0), but each connection waits for the prompt before
+// sending the next one.
+// It reports the commands per second and the latency percentiles,
+// measured from the time a command is due to the reception of the following prompt
+// (i.e., the bytes "> " at the end of the data received). With a rate, a command
+// is due at its place in the schedule, even if the connection is still waiting
+// for the previous prompt, so that a slow server doesn't hide its own delays
+// (coordinated omission). Without a rate, a command is due when it's sent.
+//
+// Without --connect, the program starts a server in the same process,
+// with a menu like the one of the example "complete".
+// With --serve, it only starts the server, so that it can be loaded from
+// another process (or host).
+
+#ifdef CLI_BENCHMARK_USE_STANDALONEASIO
+    #include <cli/standaloneasioscheduler.h>
+    #include <cli/standaloneasioremotecli.h>
+    namespace cli
+    {
+        using MainScheduler = StandaloneAsioScheduler;
+        using CliTelnetServer = StandaloneAsioCliTelnetServer;
+        namespace detail { using AsioLib = StandaloneAsioLib; }
+    } // namespace cli
+#elif defined(CLI_BENCHMARK_USE_BOOSTASIO)
+    #include <cli/boostasioscheduler.h>
+    #include <cli/boostasioremotecli.h>
+    namespace cli
+    {
+        using MainScheduler = BoostAsioScheduler;
+        using CliTelnetServer = BoostAsioCliTelnetServer;
+        namespace detail { using AsioLib = BoostAsioLib; }
+    } // namespace cli
+#else
+    #error either CLI_BENCHMARK_USE_STANDALONEASIO or CLI_BENCHMARK_USE_BOOSTASIO must be defined
+#endif
+
+#include <cli/cli.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cli;
+namespace asiolib = cli::detail::asiolib;
+namespace asiolibec = cli::detail::asiolibec;
+using AsioLib = cli::detail::AsioLib;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+struct Options
+{
+    bool serve = false; // only start the server
+    std::string host; // empty: start the server in this process
+    unsigned short port = 5000;
+    std::size_t serverThreads = 0; // see CliTelnetServer::WorkerThreads
+    std::size_t connections = 10;
+    std::size_t clientThreads = 1;
+    double rate = 0; // commands per second (all the connections), 0 = unlimited
+    double duration = 10; // seconds
+    double warmup = 1; // seconds, not measured
+    std::vector<std::string> script = {
+        "hello",
+        "answer 42",
+        "echo \"a string with spaces\"",
+        "reverse abcdefghijklmnopqrstuvwxyz",
+        "add 2 3",
+        "add 2 3 4",
+        "sort delta alpha charlie bravo",
+        "sub hello",
+        "wrong_command",
+        "answer not_a_number"
+    };
+    std::string format = "text";
+};
+
+[[noreturn]] void Usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [options]\n"
+        "  --serve                 only start the server\n"
+        "  --connect=<ip>          load the server at <ip> instead of starting it\n"
+        "  --port=<port>           the port of the server (default 5000)\n"
+        "  --server-threads=<n>    the worker threads of the server started (default 0)\n"
+        "  --connections=<n>       the number of connections (default 10)\n"
+        "  --client-threads=<n>    the threads serving the connections (default 1)\n"
+        "  --rate=<commands/s>     the rate of the commands of all the connections (default 0: unlimited)\n"
+        "  --duration=<seconds>    the duration of the measure (default 10)\n"
+        "  --warmup=<seconds>      the duration of the load before the measure (default 1)\n"
+        "  --script=<file>         the commands to send, one per line (default: a builtin script)\n"
+        "  --format=text|json|csv  the format of the report (default text)\n";
+    std::exit(EXIT_FAILURE);
+}
+
+bool Option(const std::string& arg, const std::string& option, std::string& value)
+{
+    if (arg.compare(0, option.size(), option) != 0)
+        return false;
+    value = arg.substr(option.size());
+    return true;
+}
+
+Options ParseOptions(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        std::string value;
+        if (arg == "--serve") options.serve = true;
+        else if (Option(arg, "--connect=", value)) options.host = value;
+        else if (Option(arg, "--port=", value)) options.port = static_cast<unsigned short>(std::atoi(value.c_str()));
+        else if (Option(arg, "--server-threads=", value)) options.serverThreads = static_cast<std::size_t>(std::atoi(value.c_str()));
+        else if (Option(arg, "--connections=", value)) options.connections = static_cast<std::size_t>(std::max(1, std::atoi(value.c_str())));
+        else if (Option(arg, "--client-threads=", value)) options.clientThreads = static_cast<std::size_t>(std::max(1, std::atoi(value.c_str())));
+        else if (Option(arg, "--rate=", value)) options.rate = std::atof(value.c_str());
+        else if (Option(arg, "--duration=", value)) options.duration = std::atof(value.c_str());
+        else if (Option(arg, "--warmup=", value)) options.warmup = std::atof(value.c_str());
+        else if (Option(arg, "--format=", value)) options.format = value;
+        else if (Option(arg, "--script=", value))
+        {
+            std::ifstream file(value);
+            if (!file) { std::cerr << "cannot open " << value << '\n'; std::exit(EXIT_FAILURE); }
+            options.script.clear();
+            for (std::string line; std::getline(file, line);)
+                if (!line.empty()) options.script.push_back(line);
+            if (options.script.empty()) { std::cerr << value << " has no commands\n"; std::exit(EXIT_FAILURE); }
+        }
+        else Usage(argv[0]);
+    }
+    if (options.format != "text" && options.format != "json" && options.format != "csv")
+        Usage(argv[0]);
+    return options;
+}
+
+std::unique_ptr<Menu> MakeMenu()
+{
+    auto rootMenu = std::make_unique<Menu>("cli");
+    rootMenu->Insert("hello", [](std::ostream& out){ out << "Hello, world\n"; }, "Print hello world");
+    rootMenu->Insert("answer", [](std::ostream& out, int x){ out << "The answer is: " << x << "\n"; }, "Print the answer");
+    rootMenu->Insert("echo", {"string to echo"}, [](std::ostream& out, const std::string& arg){ out << arg << "\n"; }, "Print the string passed as parameter");
+    rootMenu->Insert(
+        "reverse", {"string_to_revert"},
+        [](std::ostream& out, const std::string& arg)
+        {
+            std::string copy(arg);
+            std::reverse(copy.begin(), copy.end());
+            out << copy << "\n";
+        },
+        "Print the reverse string" );
+    rootMenu->Insert("add", [](std::ostream& out, int x, int y){ out << x << " + " << y << " = " << (x+y) << "\n"; }, "Print the sum of the two numbers");
+    rootMenu->Insert("add", [](std::ostream& out, int x, int y, int z){ out << x << " + " << y << " + " << z << " = " << (x+y+z) << "\n"; }, "Print the sum of the three numbers");
+    rootMenu->Insert(
+        "sort", {"list of strings separated by space"},
+        [](std::ostream& out, std::vector<std::string> data)
+        {
+            std::sort(data.begin(), data.end());
+            out << "sorted list: ";
+            std::copy(data.begin(), data.end(), std::ostream_iterator<std::string>(out, " "));
+            out << "\n";
+        },
+        "Alphabetically sort a list of words" );
+    auto subMenu = std::make_unique<Menu>("sub");
+    subMenu->Insert("hello", [](std::ostream& out){ out << "Hello, submenu world\n"; }, "Print hello world in the submenu");
+    rootMenu->Insert(std::move(subMenu));
+    return rootMenu;
+}
+
+// The state shared by the connections
+struct Test
+{
+    explicit Test(const Options& _options) : options(_options) {}
+    const Options& options;
+    std::atomic<std::size_t> ready{ 0 }; // the connections that received the first prompt
+    std::atomic<std::size_t> failed{ 0 };
+    Clock::time_point start; // written before the connections start sending
+    Clock::time_point measureStart;
+    Clock::time_point end;
+    std::chrono::nanoseconds interval{ 0 }; // between two commands of a connection
+};
+
+// A telnet connection sending the commands of the script
+class Connection
+{
+public:
+    Connection(AsioLib::ContextType& context, Test& _test, std::size_t _id) :
+        socket(context), timer(context), test(_test), id(_id), next(_id % _test.options.script.size())
+    {}
+
+    void Connect(const asiolib::ip::tcp::endpoint& endpoint)
+    {
+        socket.async_connect(endpoint, [this](const asiolibec::error_code& ec)
+        {
+            if (ec) { Fail(); return; }
+            Read();
+        });
+    }
+
+    // Starts sending the commands (called when all the connections are ready)
+    void Go()
+    {
+        AsioLib::Executor(socket).Post([this]()
+        {
+            // the connections are spread in the interval
+            due = test.start + test.interval * static_cast<long>(id) / static_cast<long>(test.options.connections);
+            Schedule();
+        });
+    }
+
+    void Close()
+    {
+        AsioLib::Executor(socket).Post([this]()
+        {
+            closing = true;
+            asiolibec::error_code ec;
+            timer.cancel();
+            socket.close(ec);
+        });
+    }
+
+    const std::vector<double>& Latencies() const { return latencies; } // microseconds
+    std::size_t Errors() const { return errors; }
+
+private:
+
+    void Read()
+    {
+        socket.async_read_some(asiolib::buffer(buffer), [this](const asiolibec::error_code& ec, std::size_t size)
+        {
+            if (ec)
+            {
+                if (!closing) Fail();
+                return;
+            }
+            if (Parse(buffer.data(), size))
+                OnPrompt();
+            Read();
+        });
+    }
+
+    // Handles the telnet commands and returns true when the data ends with a prompt
+    bool Parse(const char* data, std::size_t size)
+    {
+        // kept alive by the write handler
+        auto answers = std::make_shared<std::string>();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const auto c = static_cast<unsigned char>(data[i]);
+            switch (state)
+            {
+                case State::data:
+                    if (c == IAC) state = State::iac;
+                    else Data(c);
+                    break;
+                case State::iac:
+                    if (c == IAC) { Data(c); state = State::data; }
+                    else if (c == SB) state = State::sub;
+                    else if (c >= WILL && c <= DONT) { command = c; state = State::option; }
+                    else state = State::data;
+                    break;
+                case State::option:
+                    Answer(command, c, *answers);
+                    state = State::data;
+                    break;
+                case State::sub: // skips the subnegotiation up to IAC SE
+                    if (c == IAC) state = State::subIac;
+                    break;
+                case State::subIac:
+                    state = (c == SE ? State::data : State::sub);
+                    break;
+            }
+        }
+        if (!answers->empty())
+            asiolib::async_write(socket, asiolib::buffer(*answers), [answers](const asiolibec::error_code&, std::size_t){});
+        return size > 0 && state == State::data && last[0] == '>' && last[1] == ' ';
+    }
+
+    void Data(unsigned char c)
+    {
+        last[0] = last[1];
+        last[1] = static_cast<char>(c);
+    }
+
+    // accepts the echo and the suppression of go ahead, refuses the rest
+    void Answer(unsigned char cmd, unsigned char option, std::string& answers)
+    {
+        unsigned char answer = 0;
+        const bool accepted = (option == OPTION_ECHO || option == OPTION_SUPPRESS_GO_AHEAD);
+        switch (cmd)
+        {
+            case WILL: answer = accepted ? DO : DONT; break;
+            case DO: answer = accepted ? WILL : WONT; break;
+            default: return; // WONT and DONT don't need an answer
+        }
+        // answers only once to each request, to avoid loops
+        auto& answered = (cmd == WILL ? answeredWill : answeredDo);
+        if (answered[option]) return;
+        answered[option] = true;
+        answers += static_cast<char>(IAC);
+        answers += static_cast<char>(answer);
+        answers += static_cast<char>(option);
+    }
+
+    void OnPrompt()
+    {
+        if (!ready)
+        {
+            ready = true;
+            ++test.ready;
+            return;
+        }
+        if (!waiting)
+            return; // the prompt is not for a command of ours
+        waiting = false;
+        const auto now = Clock::now();
+        if (commandDue >= test.measureStart && now <= test.end)
+            latencies.push_back(std::chrono::duration<double, std::micro>(now - commandDue).count());
+        Schedule();
+    }
+
+    void Schedule()
+    {
+        const auto now = Clock::now();
+        if (now >= test.end)
+            return;
+        // with a rate, the schedule doesn't slip when the server is late
+        if (test.interval.count() == 0)
+            due = now;
+        commandDue = due;
+        timer.expires_at(due);
+        due += test.interval;
+        timer.async_wait([this](const asiolibec::error_code& ec)
+        {
+            if (!ec) Send();
+        });
+    }
+
+    void Send()
+    {
+        const auto& script = test.options.script;
+        line = script[next] + "\r\n";
+        next = (next + 1) % script.size();
+        waiting = true;
+        asiolib::async_write(socket, asiolib::buffer(line), [this](const asiolibec::error_code& ec, std::size_t)
+        {
+            if (ec) ++errors;
+        });
+    }
+
+    void Fail()
+    {
+        ++errors;
+        if (!ready)
+        {
+            ready = true;
+            ++test.failed;
+            ++test.ready;
+        }
+    }
+
+    enum : unsigned char { SE = 240, SB = 250, WILL = 251, WONT = 252, DO = 253, DONT = 254, IAC = 255 };
+    enum : unsigned char { OPTION_ECHO = 1, OPTION_SUPPRESS_GO_AHEAD = 3 };
+    enum class State { data, iac, option, sub, subIac };
+
+    asiolib::ip::tcp::socket socket;
+    AsioLib::SteadyTimer timer;
+    Test& test;
+    const std::size_t id;
+    std::size_t next; // the next command of the script
+    std::array<char, 4096> buffer;
+    State state = State::data;
+    unsigned char command = 0;
+    char last[2] = { 0, 0 }; // the last data chars received
+    bool answeredWill[256] = {};
+    bool answeredDo[256] = {};
+    bool ready = false;
+    bool waiting = false;
+    bool closing = false;
+    std::string line;
+    Clock::time_point due;
+    Clock::time_point commandDue; // when the command waiting for the prompt was due
+    std::vector<double> latencies;
+    std::size_t errors = 0;
+};
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    const auto i = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+int Load(const Options& options)
+{
+    const auto address = AsioLib::IpAddressFromString(options.host.empty() ? "127.0.0.1" : options.host);
+    const asiolib::ip::tcp::endpoint endpoint(address, options.port);
+
+    Test test(options);
+    if (options.rate > 0)
+        test.interval = std::chrono::nanoseconds(static_cast<long long>(1e9 * static_cast<double>(options.connections) / options.rate));
+
+    // each thread runs the connections of its own context
+    std::vector<std::unique_ptr<AsioLib::ContextType>> contexts;
+    for (std::size_t i = 0; i < options.clientThreads; ++i)
+        contexts.push_back(std::make_unique<AsioLib::ContextType>());
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (std::size_t i = 0; i < options.connections; ++i)
+    {
+        connections.push_back(std::make_unique<Connection>(*contexts[i % contexts.size()], test, i));
+        connections.back()->Connect(endpoint);
+    }
+    std::vector<decltype(AsioLib::MakeWorkGuard(*contexts.front()))> guards;
+    for (auto& c: contexts)
+        guards.push_back(AsioLib::MakeWorkGuard(*c));
+    std::vector<std::thread> threads;
+    for (auto& c: contexts)
+        threads.emplace_back([&c](){ c->run(); });
+
+    // waits for the first prompt on all the connections
+    const auto timeout = Clock::now() + std::chrono::seconds(10);
+    while (test.ready < options.connections && Clock::now() < timeout)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const bool connected = (test.ready == options.connections && test.failed == 0);
+    if (connected)
+    {
+        test.start = Clock::now();
+        test.measureStart = test.start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+        test.end = test.measureStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+        for (auto& c: connections)
+            c->Go();
+        std::this_thread::sleep_until(test.end);
+    }
+    for (auto& c: connections)
+        c->Close();
+    for (auto& g: guards)
+        AsioLib::Reset(g);
+    for (auto& t: threads)
+        t.join();
+
+    if (!connected)
+    {
+        std::cerr << (options.connections - test.ready + test.failed) << " connections of "
+                  << options.connections << " failed to get the prompt\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> latencies;
+    std::size_t errors = 0;
+    for (const auto& c: connections)
+    {
+        latencies.insert(latencies.end(), c->Latencies().begin(), c->Latencies().end());
+        errors += c->Errors();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const double throughput = static_cast<double>(latencies.size()) / options.duration;
+    const double p50 = Percentile(latencies, 0.5);
+    const double p99 = Percentile(latencies, 0.99);
+    const double p999 = Percentile(latencies, 0.999);
+    const double max = latencies.empty() ? 0 : latencies.back();
+
+    if (options.format == "json")
+    {
+        std::cout << "{ \"connections\": " << options.connections << ", \"rate\": " << options.rate
+                  << ", \"duration_s\": " << options.duration << ", \"commands\": " << latencies.size()
+                  << ", \"errors\": " << errors << ", \"commands_per_s\": " << throughput
+                  << ", \"latency_us\": { \"p50\": " << p50 << ", \"p99\": " << p99
+                  << ", \"p999\": " << p999 << ", \"max\": " << max << " } }\n";
+    }
+    else if (options.format == "csv")
+    {
+        std::cout << "connections,rate,duration_s,commands,errors,commands_per_s,p50_us,p99_us,p999_us,max_us\n"
+                  << options.connections << ',' << options.rate << ',' << options.duration << ','
+                  << latencies.size() << ',' << errors << ',' << throughput << ','
+                  << p50 << ',' << p99 << ',' << p999 << ',' << max << '\n';
+    }
+    else
+    {
+        std::cout << "connections:    " << options.connections << '\n'
+                  << "target rate:    " << (options.rate > 0 ? std::to_string(options.rate) + " commands/s" : "unlimited") << '\n'
+                  << "commands:       " << latencies.size() << " in " << options.duration << " s\n"
+                  << "errors:         " << errors << '\n'
+                  << "throughput:     " << throughput << " commands/s\n"
+                  << "latency (us):   p50 " << p50 << "  p99 " << p99 << "  p999 " << p999 << "  max " << max << '\n';
+    }
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const auto options = ParseOptions(argc, argv);
+        if (!options.host.empty())
+            return Load(options);
+
+        Cli cli(MakeMenu());
+        MainScheduler scheduler;
+        CliTelnetServer server(cli, scheduler, "127.0.0.1", options.port);
+        if (options.serverThreads > 0)
+            server.WorkerThreads(options.serverThreads);
+        if (options.serve)
+        {
+            std::cout << "serving on port " << options.port << std::endl;
+            scheduler.Run();
+            return EXIT_SUCCESS;
+        }
+        std::thread serverThread([&scheduler](){ scheduler.Run(); });
+        const int result = Load(options);
+        scheduler.Stop();
+        serverThread.join();
+        return result;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception caught in main: " << e.what() << '\n';
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception caught in main.\n";
+    }
+    return EXIT_FAILURE;
+}
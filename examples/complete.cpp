@@ -59,6 +59,8 @@
 #include <algorithm> // std::copy
 
 #include <complex>
+#include <future>
+#include <thread>
 
 using namespace cli;
 using namespace std;
@@ -184,6 +186,21 @@ int main()
                 "complex",
                 [](std::ostream& out, std::complex<double> x){ out << "You entered complex : " << x << "\n"; },
                 "Print a complex number" );
+        rootMenu->Insert(
+                "sleep", {"seconds"},
+                [](std::ostream&, CancellationToken token, unsigned seconds)
+                {
+                    // the prompt is back when the future is ready (or on ctrl+C),
+                    // but the scheduler keeps serving the other sessions
+                    return std::async(std::launch::async, [token, seconds]()
+                    {
+                        const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+                        while (std::chrono::steady_clock::now() < end && !token.IsCancelled())
+                            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                        return "Awake";
+                    });
+                },
+                "Wait the number of seconds specified in another thread (ctrl+C to stop)" );
         colorCmd = rootMenu->Insert(
                 "color",
                 [&](std::ostream& out)
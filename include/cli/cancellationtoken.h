@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_CANCELLATIONTOKEN_H_
+#define CLI_CANCELLATIONTOKEN_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace cli
+{
+namespace detail
+{
+
+// The cancellation state of a command, shared by its tokens
+class CancellationState
+{
+public:
+    bool IsCancelled() const { return cancelled.load(); }
+
+    // Runs the callbacks registered in the calling thread (only the first time)
+    void Cancel()
+    {
+        std::vector<std::function<void()>> cbs;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (cancelled.exchange(true))
+                return;
+            cbs.swap(callbacks);
+        }
+        for (auto& cb: cbs)
+            cb();
+    }
+
+    // Runs cb at cancellation, or right now if already cancelled
+    void OnCancel(std::function<void()> cb)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!cancelled.load())
+            {
+                callbacks.push_back(std::move(cb));
+                return;
+            }
+        }
+        cb();
+    }
+
+private:
+    std::atomic<bool> cancelled{ false };
+    std::mutex mtx;
+    std::vector<std::function<void()>> callbacks;
+};
+
+} // namespace detail
+
+/**
+ * A `CancellationToken` tells an asynchronous command that the user
+ * interrupted it (with ctrl+C) or that its session is gone.
+ * The command can poll it with `IsCancelled` (from any thread), or register
+ * a callback with `OnCancel`. The callbacks run in the thread of the session
+ * at the cancellation, so they must be short and must not throw.
+ *
+ * A default constructed token is never cancelled.
+ */
+class CancellationToken
+{
+public:
+    CancellationToken() = default;
+    explicit CancellationToken(std::shared_ptr<detail::CancellationState> _state) : state(std::move(_state)) {}
+
+    bool IsCancelled() const { return state && state->IsCancelled(); }
+
+    /// Calls @c cb when the command is cancelled
+    /// (immediately, in the calling thread, if it's already cancelled).
+    void OnCancel(std::function<void()> cb) const
+    {
+        if (state)
+            state->OnCancel(std::move(cb));
+    }
+
+private:
+    std::shared_ptr<detail::CancellationState> state;
+};
+
+} // namespace cli
+
+#endif // CLI_CANCELLATIONTOKEN_H_
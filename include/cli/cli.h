@@ -33,11 +33,20 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <algorithm>
+#include <chrono>
 #include <cctype> // std::isspace
+#include <iomanip>
+#include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
+#include <tuple>
 #include "colorprofile.h"
+#include "commandstats.h"
+#include "completion.h"
+#include "detail/statsregistry.h"
 #include "detail/history.h"
 #include "detail/split.h"
 #include "detail/fromstring.h"
@@ -83,28 +92,35 @@ namespace cli
         // std::streambuf overrides
         std::streamsize xsputn(const char* s, std::streamsize n) override
         {
+            std::lock_guard<std::mutex> lock(mtx);
             for (auto os: ostreams)
                 os->rdbuf()->sputn(s, n);
             return n;
         }
         int overflow(int c) override
         {
+            std::lock_guard<std::mutex> lock(mtx);
+            // the stream can be used by another thread: only its buffer is thread safe
             for (auto os: ostreams)
-                *os << static_cast<char>(c);
+                os->rdbuf()->sputc(static_cast<char>(c));
             return c;
         }            
 
+        // the sessions can register from different threads
         void Register(std::ostream& o)
         {
+            std::lock_guard<std::mutex> lock(mtx);
             ostreams.push_back(&o);
         }
         void UnRegister(std::ostream& o)
         {
+            std::lock_guard<std::mutex> lock(mtx);
             ostreams.erase(std::remove(ostreams.begin(), ostreams.end(), &o), ostreams.end());
         }
 
     private:
 
+        std::mutex mtx;
         std::vector<std::ostream*> ostreams;
     };
     
@@ -186,6 +202,28 @@ namespace cli
             return *CoutPtr();
         }
 
+        /**
+         * @brief Enable the statistics of the commands executed by the sessions:
+         * the number of executions, the number of errors and the latency.
+         * The sessions get also the command "stats", that prints them.
+         * It must be called before creating the sessions.
+         */
+        void EnableStats()
+        {
+            if (!stats)
+                stats = std::make_unique<detail::StatsRegistry>();
+        }
+
+        /**
+         * @brief Get the statistics of the commands executed until now by all the sessions
+         * (empty if the statistics are not enabled).
+         * It can be called by any thread.
+         */
+        CliStats GetStats() const
+        {
+            return stats ? stats->Collect() : CliStats{};
+        }
+
     private:
         friend class CliSession;
 
@@ -225,23 +263,75 @@ namespace cli
                 out << "wrong command: " << cmd << '\n';
         }
 
+        // the sessions can store and get the history from different threads
+
         void StoreCommands(const std::vector<std::string>& cmds)
         {
+            std::lock_guard<std::mutex> lock(*historyMtx);
             globalHistoryStorage->Store(cmds);
         }
 
         std::vector<std::string> GetCommands() const
         {
+            std::lock_guard<std::mutex> lock(*historyMtx);
             return globalHistoryStorage->Commands();
         }
 
+        std::shared_ptr<const HistorySnapshot> GetHistorySnapshot() const
+        {
+            std::lock_guard<std::mutex> lock(*historyMtx);
+            return globalHistoryStorage->Snapshot();
+        }
+
     private:
         std::unique_ptr<HistoryStorage> globalHistoryStorage;
+        std::unique_ptr<std::mutex> historyMtx = std::make_unique<std::mutex>(); // unique_ptr to keep Cli movable
         std::unique_ptr<Menu> rootMenu; // just to keep it alive
         std::function<void(std::ostream&)> enterAction;
         std::function<void(std::ostream&)> exitAction;
         std::function<void(std::ostream&, const std::string& cmd, const std::exception& )> exceptionHandler;
         std::function<void(std::ostream&, const std::string& cmd)> wrongCmdHandler;
+        std::unique_ptr<detail::StatsRegistry> stats; // null if the statistics are not enabled
+    };
+
+    // ********************************************************************
+
+    /**
+     * @brief A non owning view on a range of command line tokens.
+     *
+     * The commands get the command line through this view, so that going down
+     * one menu level (or up to the parent menu) does not copy the tokens.
+     */
+    class CmdLineView
+    {
+    public:
+        using const_iterator = const std::string*;
+
+        CmdLineView(const std::vector<std::string>& v) : first(v.data()), last(v.data()+v.size()) {} // NOLINT(google-explicit-constructor)
+        CmdLineView(const std::string* _first, const std::string* _last) : first(_first), last(_last) {}
+
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+        std::size_t size() const { return static_cast<std::size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const std::string& operator[](std::size_t i) const
+        {
+            assert(i < size());
+            return first[i];
+        }
+
+        // returns the view without the first token
+        CmdLineView Tail() const
+        {
+            assert(!empty());
+            return {first+1, last};
+        }
+
+        std::vector<std::string> ToVector() const { return {first, last}; }
+
+    private:
+        const std::string* first;
+        const std::string* last;
     };
 
     // ********************************************************************
@@ -260,45 +350,219 @@ namespace cli
 
         virtual void Enable() { enabled = true; }
         virtual void Disable() { enabled = false; }
-        virtual bool Exec(const std::vector<std::string>& cmdLine, CliSession& session) = 0;
+        // Executes the command if cmdLine matches it, and returns true in that case.
+        // A derived class must override (at least) one of the two overloads:
+        // new commands should override the one taking a CmdLineView, which does not
+        // copy the tokens; the one taking a vector is kept for backward compatibility.
+        // If neither is overridden, they throw std::logic_error.
+        virtual bool Exec(CmdLineView cmdLine, CliSession& session)
+        {
+            const Adapter adapter(this);
+            return Exec(cmdLine.ToVector(), session);
+        }
+        virtual bool Exec(const std::vector<std::string>& cmdLine, CliSession& session)
+        {
+            // called back by the overload taking a CmdLineView: no override
+            if (Adapter::Current() == this)
+                throw std::logic_error("Command::Exec not overridden");
+            return Exec(CmdLineView(cmdLine), session);
+        }
         virtual void Help(std::ostream& out) const = 0;
+        // Returns false if Exec can handle the command lines whose first token
+        // is not the name of the command (e.g., aliases): the menus try these
+        // commands on every line, instead of only on the lines starting with
+        // their name. It must always return the same value.
+        virtual bool DispatchByName() const { return true; }
         // Returns the collection of completions relatives to this command.
         // For simple commands, provides a base implementation that use the name of the command
         // for aggregate commands (i.e., Menu), the function is redefined to give the menu command
-        // and the subcommand recursively
+        // and the subcommand recursively.
+        // The menus call it only when the name of the command starts with line
+        // or line starts with the name of the command, or when the command is not
+        // dispatched by name (see DispatchByName).
         virtual std::vector<std::string> GetCompletionRecursive(const std::string& line) const
         {
             if (!enabled) return {};
             if (name.rfind(line, 0) == 0) return {name}; // name starts_with line
             return {};
         }
-    protected:
         const std::string& Name() const { return name; }
+    protected:
         bool IsEnabled() const { return enabled; }
     private:
+
+        // marks (per thread) the command whose Exec(CmdLineView) default
+        // implementation is calling the overload taking a vector
+        class Adapter
+        {
+        public:
+            explicit Adapter(const Command* cmd) : previous(Current()) { Current() = cmd; }
+            ~Adapter() { Current() = previous; }
+            Adapter(const Adapter&) = delete;
+            Adapter& operator=(const Adapter&) = delete;
+            static const Command*& Current()
+            {
+                static thread_local const Command* current = nullptr;
+                return current;
+            }
+        private:
+            const Command* const previous;
+        };
+
         const std::string name;
         bool enabled;
     };
 
     // ********************************************************************
 
+    // The commands of a menu.
+    // Besides keeping the commands in insertion order (for help and completion),
+    // it indexes them by name, so that a command line is only tried on the
+    // commands having the same name of its first token (i.e., the overloads),
+    // and then on the commands not dispatched by name (see Command::DispatchByName).
+    // For the completion, the commands are also sorted by name (when a completion
+    // is requested after a change), so that only the commands whose name matches
+    // the line are considered.
+    class CommandSet
+    {
+    public:
+        using Container = std::vector<std::shared_ptr<Command>>;
+        using const_iterator = Container::const_iterator;
+
+        explicit CommandSet(const Menu* _owner = nullptr) : owner(_owner) {}
+
+        void Add(const std::shared_ptr<Command>& cmd)
+        {
+            cmds.push_back(cmd);
+            if (cmd->DispatchByName())
+                index[cmd->Name()].push_back(cmd.get());
+            else
+                unindexed.push_back(cmd.get());
+            std::lock_guard<std::mutex> lock(sortedMtx);
+            sortedValid = false;
+        }
+
+        void Remove(const Command* cmd)
+        {
+            auto i = std::find_if(cmds.begin(), cmds.end(), [cmd](const auto& c){ return c.get() == cmd; });
+            if (i == cmds.end())
+                return;
+            if (cmd->DispatchByName())
+            {
+                auto overloads = index.find(cmd->Name());
+                assert(overloads != index.end());
+                auto& v = overloads->second;
+                v.erase(std::remove(v.begin(), v.end(), cmd), v.end());
+                if (v.empty())
+                    index.erase(overloads);
+            }
+            else
+                unindexed.erase(std::remove(unindexed.begin(), unindexed.end(), cmd), unindexed.end());
+            {
+                std::lock_guard<std::mutex> lock(sortedMtx);
+                sortedValid = false;
+                sorted.clear(); // it points to the names of the commands
+            }
+            cmds.erase(i); // last, because it can destroy the command
+        }
+
+        // Try the commands named cmdLine[0], and then the ones not dispatched
+        // by name, in insertion order.
+        // Returns true as soon as one of them handles the command line.
+        bool Exec(CmdLineView cmdLine, CliSession& session) const;
+
+        // Returns the commands that can complete line, in insertion order:
+        // the ones whose name starts with line, the ones whose name
+        // is a prefix of line (i.e., the menus whose subcommands can complete it),
+        // and the ones not dispatched by name (like CommandSet::Exec does).
+        std::vector<Command*> CompletionCandidates(const std::string& line) const
+        {
+            std::vector<std::size_t> found; // positions in cmds
+            {
+                std::lock_guard<std::mutex> lock(sortedMtx);
+                if (!sortedValid)
+                    Sort();
+                const auto byName = [](const Entry& e, const std::string& name){ return *e.name < name; };
+                // the names starting with line are contiguous
+                for (auto e = std::lower_bound(sorted.begin(), sorted.end(), line, byName);
+                     e != sorted.end() && e->name->compare(0, line.size(), line) == 0;
+                     ++e)
+                    found.push_back(e->pos);
+                std::string prefix;
+                for (std::size_t len = 0; len < line.size(); ++len)
+                {
+                    prefix.assign(line, 0, len);
+                    for (auto e = std::lower_bound(sorted.begin(), sorted.end(), prefix, byName);
+                         e != sorted.end() && *e->name == prefix;
+                         ++e)
+                        found.push_back(e->pos);
+                }
+                found.insert(found.end(), unindexedPos.begin(), unindexedPos.end());
+            }
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+            std::vector<Command*> result;
+            result.reserve(found.size());
+            for (auto pos: found)
+                result.push_back(cmds[pos].get());
+            return result;
+        }
+
+        const_iterator begin() const { return cmds.begin(); }
+        const_iterator end() const { return cmds.end(); }
+
+    private:
+        struct Entry
+        {
+            const std::string* name;
+            std::size_t pos; // in cmds
+        };
+
+        bool Exec(const std::vector<Command*>& candidates, CmdLineView cmdLine, CliSession& session) const;
+
+        void Sort() const
+        {
+            sorted.clear();
+            sorted.reserve(cmds.size());
+            unindexedPos.clear();
+            for (std::size_t i = 0; i < cmds.size(); ++i)
+            {
+                sorted.push_back(Entry{ &cmds[i]->Name(), i });
+                if (!cmds[i]->DispatchByName())
+                    unindexedPos.push_back(i);
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b){ return *a.name < *b.name; });
+            sortedValid = true;
+        }
+
+        const Menu* const owner; // the menu of the commands
+        Container cmds;
+        std::unordered_map<std::string, std::vector<Command*>> index;
+        std::vector<Command*> unindexed; // the commands not dispatched by name
+        // the sessions can ask for completions concurrently
+        mutable std::mutex sortedMtx;
+        mutable std::vector<Entry> sorted; // by name
+        mutable std::vector<std::size_t> unindexedPos; // positions in cmds of unindexed
+        mutable bool sortedValid = false;
+    };
+
+    // ********************************************************************
+
     // free utility function to get completions from a list of commands and the current line
     inline std::vector<std::string> GetCompletions(
-        const std::shared_ptr<std::vector<std::shared_ptr<Command>>>& cmds,
+        const CommandSet& cmds,
         const std::string& currentLine)
     {
         std::vector<std::string> result;
-        std::for_each(cmds->begin(), cmds->end(),
-            [&currentLine,&result](const auto& cmd)
-            {
-                auto c = cmd->GetCompletionRecursive(currentLine);
-                result.insert(
-                    result.end(),
-                    std::make_move_iterator(c.begin()),
-                    std::make_move_iterator(c.end())
-                );
-            }
-        );
+        for (const auto* cmd: cmds.CompletionCandidates(currentLine))
+        {
+            auto c = cmd->GetCompletionRecursive(currentLine);
+            result.insert(
+                result.end(),
+                std::make_move_iterator(c.begin()),
+                std::make_move_iterator(c.end())
+            );
+        }
         return result;
     }
 
@@ -337,6 +601,7 @@ namespace cli
 
         void Exit()
         {
+            CancelPending(); // the running command, if any, can't print anymore
             exitAction(out);
             cli.ExitAction(out);
 
@@ -375,10 +640,83 @@ namespace cli
             return history.Next();
         }
 
+        // Searches the newest command in the history containing text,
+        // starting from the command with the given index (0 is the newest).
+        // If found, returns true and sets index and cmd.
+        bool SearchCmd(const std::string& text, std::size_t& index, std::string& cmd) const
+        {
+            return history.Search(text, index, cmd);
+        }
+
         std::vector<std::string> GetCompletions(std::string currentLine) const;
 
+        void ShowStats() const;
+
+        /// The asynchronous commands started by the session will complete
+        /// in the thread of @c s (that must be the one feeding the session).
+        /// Without a scheduler, @c Feed waits for them.
+        void UseScheduler(Scheduler& s) { scheduler = &s; }
+
+        /// Starts an asynchronous command, that ends when the returned
+        /// @c Completion is invoked. Meanwhile, the session is busy:
+        /// the prompt is not shown.
+        Completion StartAsync();
+
+        /// Returns true while an asynchronous command is running.
+        bool Busy() const { return pending != nullptr; }
+
+        /// Cancels the asynchronous command running, if any (see @c CancellationToken),
+        /// and goes on without waiting for its completion.
+        /// Returns false if there is no command running.
+        bool Interrupt();
+
+    protected:
+
+        /// Called when an asynchronous command is completed
+        /// and the session has a scheduler. It shows the prompt.
+        virtual void OnCommandCompleted() { Prompt(); }
+
     private:
 
+        friend class CommandSet;
+
+        // the command cmd of the menu has handled the current line (or thrown).
+        // Only the first call for a line is kept: the command innermost in the menus.
+        void Executed(const Command* cmd, const Menu* menu)
+        {
+            if (statsShard && executedCmd == nullptr)
+            {
+                executedCmd = cmd;
+                executedMenu = menu;
+            }
+        }
+
+        void RecordStats(std::chrono::steady_clock::time_point start, bool error);
+
+        // runs the end of the pending command, and records its stats
+        void Completed();
+
+        // forgets the pending command, if any
+        void DropPending()
+        {
+            if (pending)
+            {
+                pending->session = nullptr; // a late completion is ignored
+                pending.reset();
+            }
+        }
+
+        // forgets the pending command, if any, and cancels its token
+        void CancelPending()
+        {
+            if (pending)
+            {
+                auto p = pending;
+                DropPending();
+                p->cancellation->Cancel();
+            }
+        }
+
         Cli& cli;
         std::shared_ptr<cli::OutStream> coutPtr;
         Menu* current;
@@ -387,7 +725,22 @@ namespace cli
         std::function< void(std::ostream&)> enterAction = []( std::ostream& ) noexcept {};
         std::function< void(std::ostream&)> exitAction = []( std::ostream& ) noexcept {};
         detail::History history;
+        std::vector<std::string> tokens; // buffers reused by Feed to split the lines
         bool exit{ false }; // to prevent the prompt after exit command
+        std::shared_ptr<detail::StatsShard> statsShard; // null if the statistics are not enabled
+        // the command that handled the line being executed, and its menu
+        // (a nested Feed, e.g. from history, resets them when it ends)
+        const Command* executedCmd = nullptr;
+        const Menu* executedMenu = nullptr;
+        std::string statsKey; // buffer reused to build the name of the command executed
+        Scheduler* scheduler = nullptr; // where the asynchronous commands complete, if any
+        // the asynchronous command running, with its command line and start time
+        std::shared_ptr<detail::AsyncCommand> pending;
+        std::string pendingLine;
+        std::chrono::steady_clock::time_point pendingStart;
+        // the line being executed by Feed (null outside Feed), and its start time
+        const std::string* feedLine = nullptr;
+        std::chrono::steady_clock::time_point feedStart;
     };
 
     // ********************************************************************
@@ -395,9 +748,8 @@ namespace cli
     class CmdHandler
     {
     public:
-        using CmdVec = std::vector<std::shared_ptr<Command>>;
         CmdHandler() : descriptor(std::make_shared<Descriptor>()) {}
-        CmdHandler(std::weak_ptr<Command> c, std::weak_ptr<CmdVec> v) :
+        CmdHandler(std::weak_ptr<Command> c, std::weak_ptr<CommandSet> v) :
             descriptor(std::make_shared<Descriptor>(c, v))
         {}
         void Enable() { if (descriptor) descriptor->Enable(); }
@@ -407,7 +759,7 @@ namespace cli
         struct Descriptor
         {
             Descriptor() = default;
-            Descriptor(std::weak_ptr<Command> c, std::weak_ptr<CmdVec> v) :
+            Descriptor(std::weak_ptr<Command> c, std::weak_ptr<CommandSet> v) :
                 cmd(std::move(c)), cmds(std::move(v))
             {}
             void Enable()
@@ -425,18 +777,10 @@ namespace cli
                 auto scmd = cmd.lock();
                 auto scmds = cmds.lock();
                 if (scmd && scmds)
-                {
-                    auto i = std::find_if(
-                        scmds->begin(),
-                        scmds->end(),
-                        [&](const auto& c){ return c.get() == scmd.get(); }
-                    );
-                    if (i != scmds->end())
-                        scmds->erase(i);
-                }
+                    scmds->Remove(scmd.get());
             }
             std::weak_ptr<Command> cmd;
-            std::weak_ptr<CmdVec> cmds;
+            std::weak_ptr<CommandSet> cmds;
         };
         std::shared_ptr<Descriptor> descriptor;
     };
@@ -452,18 +796,24 @@ namespace cli
         Menu(Menu&&) = delete;
         Menu& operator = (Menu&&) = delete;
 
-        Menu() : Command({}), parent(nullptr), description(), cmds(std::make_shared<Cmds>()) {}
+        Menu() : Command({}), parent(nullptr), description(), cmds(std::make_shared<Cmds>(this)) {}
 
         explicit Menu(const std::string& _name, std::string desc = "(menu)", const std::string& _prompt="") :
             Command(_name),
             parent(nullptr),
             description(std::move(desc)),
             prompt(_prompt.empty() ? _name : _prompt),
-            cmds(std::make_shared<Cmds>())
+            cmds(std::make_shared<Cmds>(this))
         {}
 
         template <typename R, typename ... Args>
         CmdHandler Insert(const std::string& cmdName, R (*f)(std::ostream&, Args...), const std::string& help, const std::vector<std::string>& parDesc={});
+
+        template <typename R, typename ... Args>
+        CmdHandler Insert(const std::string& cmdName, R (*f)(std::ostream&, Completion, Args...), const std::string& help, const std::vector<std::string>& parDesc={});
+
+        template <typename R, typename ... Args>
+        CmdHandler Insert(const std::string& cmdName, R (*f)(std::ostream&, CancellationToken, Args...), const std::string& help, const std::vector<std::string>& parDesc={});
         
         template <typename F>
         CmdHandler Insert(const std::string& cmdName, F f, const std::string& help = "", const std::vector<std::string>& parDesc={})
@@ -483,7 +833,7 @@ namespace cli
         {
             std::shared_ptr<Command> scmd(std::move(cmd));
             CmdHandler c(scmd, cmds);
-            cmds->push_back(scmd);
+            cmds->Add(scmd);
             return c;
         }
 
@@ -492,28 +842,29 @@ namespace cli
             std::shared_ptr<Menu> smenu(std::move(menu));
             CmdHandler c(smenu, cmds);
             smenu->parent = this;
-            cmds->push_back(smenu);
+            cmds->Add(smenu);
             return c;
         }
 
-        bool Exec(const std::vector<std::string>& cmdLine, CliSession& session) override
+        using Command::Exec;
+
+        bool Exec(CmdLineView cmdLine, CliSession& session) override
         {
-            return HandleCommand({Name()}, cmdLine, session);
+            return HandleCommand(false, cmdLine, session);
         }
 
-        bool ExecParent(const std::vector<std::string>& cmdLine, CliSession& session)
+        bool ExecParent(CmdLineView cmdLine, CliSession& session)
         {
-            return HandleCommand({Name(), ParentShortcut()}, cmdLine, session);
+            return HandleCommand(true, cmdLine, session);
         }
 
-        bool ScanCmds(const std::vector<std::string>& cmdLine, CliSession& session)
+        bool ScanCmds(CmdLineView cmdLine, CliSession& session)
         {
             if (!IsEnabled())
                 return false;
-            for (auto& cmd: *cmds)
-                if (cmd->Exec(cmdLine, session))
-                    return true;
             assert(!cmdLine.empty());
+            if (cmds->Exec(cmdLine, session))
+                return true;
             return (parent && parent->ExecParent(cmdLine, session));
         }
 
@@ -543,7 +894,7 @@ namespace cli
         // - the recursive completions of parent menu
         std::vector<std::string> GetCompletions(const std::string& currentLine) const
         {
-            auto result = cli::GetCompletions(cmds, currentLine);
+            auto result = cli::GetCompletions(*cmds, currentLine);
             if (parent != nullptr)
             {
                 auto c = parent->GetCompletionWithParent(currentLine);
@@ -613,12 +964,8 @@ namespace cli
             // trim_left(rest);
             rest.erase(rest.begin(), std::find_if(rest.begin(), rest.end(), [](int ch) { return !std::isspace(ch); }));
             std::vector<std::string> result;
-            for (const auto& cmd: *cmds)
-            {
-                auto cs = cmd->GetCompletionRecursive(rest);
-                for (const auto& c: cs)
-                    result.push_back(prefix + ' ' + c); // concat submenu with command
-            }
+            for (const auto& c: cli::GetCompletions(*cmds, rest))
+                result.push_back(prefix + ' ' + c); // concat submenu with command
             if (parent != nullptr)
             {
                 auto cs = parent->GetCompletionWithParent(rest);
@@ -631,14 +978,16 @@ namespace cli
         /**
          * Handles a command from the user input.
          *
-         * This function checks if the first element of the `cmdLine` vector matches any of the
-         * valid commands listed in `cmdNames`. If it does, it performs the following actions:
+         * This function checks if the first element of the `cmdLine` matches the name of this
+         * menu (or the parent shortcut, if `parentShortcut` is true). If it does, it performs
+         * the following actions:
          *   - If the `cmdLine` is of length 1 (only the command itself), it sets the current
          *     session to this object (`session.Current(this)`) and returns true.
-         *   - If the `cmdLine` is longer (includes subcommands), it iterates through registered
-         *     subcommands (`*cmds`) and calls their `Exec` function with the subcommand arguments
-         *     (`subCmdLine`) and the session (`session`). If any subcommand successfully handles
-         *     the command, it returns true.
+         *   - If the `cmdLine` is longer (includes subcommands), it looks up the registered
+         *     subcommands (`*cmds`) named as the first subcommand token and calls their `Exec`
+         *     function with the subcommand arguments (the tail of `cmdLine`, without copying it)
+         *     and the session (`session`).
+         *     If any subcommand successfully handles the command, it returns true.
          *   - If no subcommand handles the command and a parent object (`parent`) is set, it
          *     calls the parent's `ExecParent` function with the subcommand arguments and the
          *     session.
@@ -646,19 +995,19 @@ namespace cli
          * The function returns false if the command is not found, not enabled, or no subcommand or
          * parent can handle it.
          *
-         * @param cmdNames  - List of valid command names.
+         * @param parentShortcut - true if the parent shortcut is a valid command name, too.
          * @param cmdLine   - User input divided into tokens (command and arguments).
          * @param session   - Reference to the current CliSession object.
          * @return true if the command is handled successfully, false otherwise.
          */
-        bool HandleCommand(const std::vector<std::string>& cmdNames, const std::vector<std::string>& cmdLine, CliSession& session)
+        bool HandleCommand(bool parentShortcut, CmdLineView cmdLine, CliSession& session)
         {
             if (!IsEnabled())
                 return false;
 
             assert(!cmdLine.empty());
 
-            if (std::find(cmdNames.begin(), cmdNames.end(), cmdLine[0]) != cmdNames.end())
+            if (cmdLine[0] == Name() || (parentShortcut && cmdLine[0] == ParentShortcut()))
             {
                 if (cmdLine.size() == 1)
                 {
@@ -668,70 +1017,104 @@ namespace cli
                 else
                 {
                     // check also for subcommands
-                    std::vector<std::string > subCmdLine(cmdLine.begin()+1, cmdLine.end());
-                    for (auto& cmd: *cmds)
-                        if (cmd->Exec( subCmdLine, session )) return true;
+                    const auto subCmdLine = cmdLine.Tail();
+                    if (cmds->Exec( subCmdLine, session )) return true;
                     return (parent && parent->ExecParent(subCmdLine, session));
                 }
             }
             return false;
         }
 
-        static std::string ParentShortcut()
+        static const std::string& ParentShortcut()
         {
-            return "..";
+            static const std::string shortcut("..");
+            return shortcut;
         }
 
         template <typename F, typename R, typename ... Args>
         CmdHandler Insert(const std::string& name, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, Args...) const);
 
+        template <typename F, typename R, typename ... Args>
+        CmdHandler Insert(const std::string& name, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, Completion, Args...) const);
+
+        template <typename F, typename R, typename ... Args>
+        CmdHandler Insert(const std::string& name, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, CancellationToken, Args...) const);
+
+        // the handlers taking a CancellationToken must return a std::future
+        template <typename F, typename ... Args>
+        static std::unique_ptr<Command> MakeCancellableCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc);
+
+        // the handlers returning a std::future are asynchronous commands
+        template <typename F, typename ... Args>
+        static std::unique_ptr<Command> MakeCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc, std::false_type /*future*/);
+
+        template <typename F, typename ... Args>
+        static std::unique_ptr<Command> MakeCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc, std::true_type /*future*/);
+
         template <typename F, typename R>
         CmdHandler Insert(const std::string& name, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, const std::vector<std::string>&) const);
 
         template <typename F, typename R>
         CmdHandler Insert(const std::string& name, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, std::vector<std::string>) const);
 
+        friend class CliSession; // to get the path of a command
+
         Menu* parent{ nullptr };
         const std::string description;
         const std::string prompt;
         // using shared_ptr instead of unique_ptr to get a weak_ptr
         // for the CmdHandler::Descriptor
-        using Cmds = std::vector<std::shared_ptr<Command>>;
+        using Cmds = CommandSet;
         std::shared_ptr<Cmds> cmds;
     };
 
     // ********************************************************************
 
+    // Converts the parameters of a command line and invokes a function with them.
+    // The conversion is done in advance for all the parameters (Parse), so that a
+    // command line not matching the signature is rejected without throwing and
+    // without invoking the function.
     template <typename ... Args>
-    struct Select;
-
-    template <typename P, typename ... Args>
-    struct Select<P, Args...>
+    struct Select
     {
-        template <typename F, typename InputIt>
-        static void Exec(const F& f, InputIt first, InputIt last)
-        {
-            assert( first != last );
-            assert( std::distance(first, last) == 1+sizeof...(Args) );
-            const P p = detail::from_string<typename std::decay<P>::type>(*first);
-            auto g = [&](auto ... pars){ f(p, pars...); };
-            Select<Args...>::Exec(g, std::next(first), last);
-        }
-    };
+        using Values = std::tuple<typename std::decay<Args>::type...>;
 
-    template <>
-    struct Select<>
-    {
-        template <typename F, typename InputIt>
-        static void Exec(const F& f, InputIt first, InputIt last)
+        // Returns false if any of the strings in [first, last)
+        // can't be converted into the corresponding parameter type.
+        template <typename InputIt>
+        static bool Parse(InputIt first, InputIt last, Values& values)
         {
             // silence the unused warning in release mode when assert is disabled
-            static_cast<void>(first);
             static_cast<void>(last);
 
-            assert(first == last);
-            
-            f();
+            assert( std::distance(first, last) == sizeof...(Args) );
+            return Parse(first, values, std::index_sequence_for<Args...>());
+        }
+
+        template <typename F>
+        static void Exec(const F& f, Values& values)
+        {
+            Exec(f, values, std::index_sequence_for<Args...>());
+        }
+
+    private:
+        template <typename InputIt, std::size_t ... Is>
+        static bool Parse(InputIt first, Values& values, std::index_sequence<Is...>)
+        {
+            bool ok = true;
+            // the elements of a braced-init-list are evaluated in order,
+            // so the conversion stops at the first failure
+            const bool results[] = { true, (ok = ok && detail::try_from_string(*std::next(first, Is), std::get<Is>(values)))... };
+            static_cast<void>(results);
+            static_cast<void>(first); // unused when Args is empty
+            return ok;
+        }
+
+        template <typename F, std::size_t ... Is>
+        static void Exec(const F& f, Values& values, std::index_sequence<Is...>)
+        {
+            static_cast<void>(values); // unused when Args is empty
+            f(std::get<Is>(values)...);
         }
     };
 
@@ -774,22 +1157,77 @@ namespace cli
         {
         }
 
-        bool Exec(const std::vector< std::string >& cmdLine, CliSession& session) override
+        using Command::Exec;
+
+        bool Exec(CmdLineView cmdLine, CliSession& session) override
         {
             if (!IsEnabled()) return false;
             const std::size_t paramSize = sizeof...(Args);
             if (cmdLine.size() != paramSize+1) return false;
             if (Name() == cmdLine[0])
             {
-                try
-                {
-                    auto g = [&](auto ... pars){ func( session.OutStream(), pars... ); };
-                    Select<Args...>::Exec(g, std::next(cmdLine.begin()), cmdLine.end());
-                }
-                catch (std::bad_cast&)
-                {
+                typename Select<Args...>::Values values;
+                if (!Select<Args...>::Parse(std::next(cmdLine.begin()), cmdLine.end(), values))
                     return false;
-                }
+                auto g = [&](auto& ... pars){ func( session.OutStream(), pars... ); };
+                Select<Args...>::Exec(g, values);
+                return true;
+            }
+            return false;
+        }
+
+        void Help(std::ostream& out) const override
+        {
+            if (!IsEnabled()) return;
+            out << " - " << Name();
+            if (parameterDesc.empty())
+                PrintDesc<Args...>::Dump(out);
+            for (auto& s: parameterDesc)
+                out << " <" << s << '>';
+            out << "\n\t" << description << "\n";
+        }
+
+    private:
+
+        const F func;
+        const std::string description;
+        const std::vector<std::string> parameterDesc;
+    };
+
+
+    // A command whose handler receives a Completion, to end it asynchronously.
+    template <typename F, typename ... Args>
+    class AsyncFunctionCommand : public Command
+    {
+    public:
+        // disable value semantics
+        AsyncFunctionCommand(const AsyncFunctionCommand&) = delete;
+        AsyncFunctionCommand& operator = (const AsyncFunctionCommand&) = delete;
+
+        AsyncFunctionCommand(
+            const std::string& _name,
+            F fun,
+            std::string desc,
+            std::vector<std::string> parDesc
+        )
+            : Command(_name), func(std::move(fun)), description(std::move(desc)), parameterDesc(std::move(parDesc))
+        {
+        }
+
+        using Command::Exec;
+
+        bool Exec(CmdLineView cmdLine, CliSession& session) override
+        {
+            if (!IsEnabled()) return false;
+            const std::size_t paramSize = sizeof...(Args);
+            if (cmdLine.size() != paramSize+1) return false;
+            if (Name() == cmdLine[0])
+            {
+                typename Select<Args...>::Values values;
+                if (!Select<Args...>::Parse(std::next(cmdLine.begin()), cmdLine.end(), values))
+                    return false;
+                auto g = [&](auto& ... pars){ func( session.OutStream(), session.StartAsync(), pars... ); };
+                Select<Args...>::Exec(g, values);
                 return true;
             }
             return false;
@@ -832,7 +1270,9 @@ namespace cli
         {
         }
 
-        bool Exec(const std::vector< std::string >& cmdLine, CliSession& session) override
+        using Command::Exec;
+
+        bool Exec(CmdLineView cmdLine, CliSession& session) override
         {
             if (!IsEnabled()) return false;
             assert(!cmdLine.empty());
@@ -884,7 +1324,7 @@ namespace cli
             out(_out),
             history(historySize)
         {
-            history.LoadCommands(cli.GetCommands());
+            history.LoadCommands(cli.GetHistorySnapshot());
 
             coutPtr->Register(out);
             globalScopeMenu->Insert(
@@ -907,16 +1347,42 @@ namespace cli
                 [this](std::ostream&, unsigned cmdIndex){ ExecFromHistory(cmdIndex); },
                 "Exec a command by index in the history"
             );
+            if (cli.stats)
+            {
+                statsShard = cli.stats->NewShard();
+                globalScopeMenu->Insert(
+                    "stats",
+                    [this](std::ostream&){ ShowStats(); },
+                    "Show the statistics of the commands"
+                );
+            }
         }
 
     inline void CliSession::Feed(const std::string& cmd)
     {
-        std::vector<std::string> strs;
-        detail::split(strs, cmd);
-        if (strs.empty()) return; // just hit enter
+        // reuse the token buffers of the previous line
+        // (a nested Feed, e.g. from history, gets an empty vector instead)
+        std::vector<std::string> buffers;
+        buffers.swap(tokens);
+        const std::size_t nTokens = detail::SplitInto(buffers, cmd);
+        const CmdLineView strs(buffers.data(), buffers.data() + nTokens);
+        if (strs.empty()) // just hit enter
+        {
+            tokens.swap(buffers);
+            return;
+        }
 
         history.NewCommand(cmd); // add anyway to history
 
+        const auto start = statsShard ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        bool error = false;
+        // the line that StartAsync gives to the asynchronous command, if any
+        // (a nested Feed, e.g. from history, starts the command of its own line)
+        const std::string* const outerLine = feedLine;
+        const auto outerStart = feedStart;
+        feedLine = &cmd;
+        feedStart = start;
+
         try
         {
             // global cmds check
@@ -930,19 +1396,161 @@ namespace cli
         }
         catch(const std::exception& e)
         {
+            error = true;
+            CancelPending();
             cli.StdExceptionHandler(out, cmd, e);
         }
         catch(...)
         {
+            error = true;
+            CancelPending();
             out << "Cli. Unknown exception caught handling command line \""
                 << cmd
                 << "\"\n";
         }
+
+        feedLine = outerLine;
+        feedStart = outerStart;
+
+        if (pending)
+        {
+            // an asynchronous command: without a scheduler wait for its end,
+            // otherwise it's completed by the scheduler (see StartAsync)
+            if (scheduler == nullptr)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(pending->mtx);
+                    pending->cv.wait(lock, [this](){ return pending->done; });
+                }
+                Completed();
+            }
+        }
+        else if (statsShard)
+            RecordStats(start, error);
+
+        tokens.swap(buffers);
+    }
+
+    inline Completion CliSession::StartAsync()
+    {
+        assert(!pending);
+        pending = std::make_shared<detail::AsyncCommand>();
+        pending->session = this;
+        if (feedLine != nullptr)
+        {
+            pendingLine = *feedLine;
+            pendingStart = feedStart;
+        }
+        if (scheduler != nullptr)
+        {
+            pending->scheduler = scheduler;
+            std::weak_ptr<detail::AsyncCommand> weakPending = pending;
+            pending->resume = [weakPending]()
+            {
+                // the session is still waiting for this command
+                auto p = weakPending.lock();
+                if (p && p->session)
+                {
+                    auto* session = p->session; // reset by Completed
+                    session->Completed();
+                    session->OnCommandCompleted();
+                }
+            };
+        }
+        return Completion(pending);
+    }
+
+    inline bool CliSession::Interrupt()
+    {
+        if (!pending)
+            return false;
+        CancelPending();
+        if (statsShard)
+            RecordStats(pendingStart, true);
+        OnCommandCompleted();
+        return true;
+    }
+
+    inline void CliSession::Completed()
+    {
+        assert(pending);
+        std::function<void(std::ostream&)> then;
+        {
+            std::lock_guard<std::mutex> lock(pending->mtx);
+            then = std::move(pending->then);
+        }
+        DropPending();
+
+        bool error = false;
+        if (then)
+        {
+            try
+            {
+                then(out);
+            }
+            catch(const std::exception& e)
+            {
+                error = true;
+                cli.StdExceptionHandler(out, pendingLine, e);
+            }
+            catch(...)
+            {
+                error = true;
+                out << "Cli. Unknown exception caught handling command line \""
+                    << pendingLine
+                    << "\"\n";
+            }
+        }
+
+        if (statsShard)
+            RecordStats(pendingStart, error);
+    }
+
+    inline void CliSession::RecordStats(std::chrono::steady_clock::time_point start, bool error)
+    {
+        if (executedCmd == nullptr)
+        {
+            // no command handled the line
+            statsShard->WrongCommand();
+            return;
+        }
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        // the name of the command, preceded by the names of its menus
+        // (but the root one, that has no parent)
+        statsKey = executedCmd->Name();
+        for (const Menu* m = executedMenu; m != nullptr && m->parent != nullptr; m = m->parent)
+        {
+            statsKey.insert(0, 1, ' ');
+            statsKey.insert(0, m->Name());
+        }
+        statsShard->Record(statsKey, static_cast<std::uint64_t>(us), error);
+        executedCmd = nullptr;
+        executedMenu = nullptr;
+    }
+
+    inline void CliSession::ShowStats() const
+    {
+        const auto stats = cli.GetStats();
+        std::size_t width = 7;
+        for (const auto& s: stats.commands)
+            width = std::max(width, s.command.size());
+        out << std::left << std::setw(static_cast<int>(width)) << "command" << std::right
+            << std::setw(10) << "count" << std::setw(10) << "errors"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+            << std::setw(10) << "p999 us" << std::setw(10) << "max us" << '\n';
+        for (const auto& s: stats.commands)
+        {
+            out << std::left << std::setw(static_cast<int>(width)) << s.command << std::right
+                << std::setw(10) << s.count << std::setw(10) << s.errors
+                << std::setw(10) << s.latency.Percentile(0.5) << std::setw(10) << s.latency.Percentile(0.99)
+                << std::setw(10) << s.latency.Percentile(0.999) << std::setw(10) << s.latency.Max() << '\n';
+        }
+        out << "wrong commands: " << stats.wrongCommands << '\n';
     }
 
     inline void CliSession::Prompt()
     {
-        if (exit) return;
+        if (exit || pending) return;
         out << beforePrompt
             << current->Prompt()
             << afterPrompt
@@ -975,7 +1583,44 @@ namespace cli
 
     inline CliSession::~CliSession() noexcept
     {
+        CancelPending();
         coutPtr->UnRegister(out);
+        if (statsShard)
+            cli.stats->Retire(statsShard);
+    }
+
+    // CommandSet implementation
+
+    inline bool CommandSet::Exec(CmdLineView cmdLine, CliSession& session) const
+    {
+        assert(!cmdLine.empty());
+        auto overloads = index.find(cmdLine[0]);
+        if (overloads != index.end() && Exec(overloads->second, cmdLine, session))
+            return true;
+        return !unindexed.empty() && Exec(unindexed, cmdLine, session);
+    }
+
+    inline bool CommandSet::Exec(const std::vector<Command*>& candidates, CmdLineView cmdLine, CliSession& session) const
+    {
+        for (auto* cmd: candidates)
+        {
+            bool handled = false;
+            try
+            {
+                handled = cmd->Exec(cmdLine, session);
+            }
+            catch (...)
+            {
+                session.Executed(cmd, owner);
+                throw;
+            }
+            if (handled)
+            {
+                session.Executed(cmd, owner);
+                return true;
+            }
+        }
+        return false;
     }
 
     // Menu implementation
@@ -984,13 +1629,63 @@ namespace cli
     CmdHandler Menu::Insert(const std::string& cmdName, R (*f)(std::ostream&, Args...), const std::string& help, const std::vector<std::string>& parDesc)
     {
         using F = R (*)(std::ostream&, Args...);
-        return Insert(std::make_unique<VariadicFunctionCommand<F, Args ...>>(cmdName, f, help, parDesc));
+        return Insert(MakeCommand<F, Args ...>(cmdName, f, help, parDesc, detail::IsFuture<R>()));
+    }
+
+    template <typename R, typename ... Args>
+    CmdHandler Menu::Insert(const std::string& cmdName, R (*f)(std::ostream&, Completion, Args...), const std::string& help, const std::vector<std::string>& parDesc)
+    {
+        using F = R (*)(std::ostream&, Completion, Args...);
+        return Insert(std::make_unique<AsyncFunctionCommand<F, Args ...>>(cmdName, f, help, parDesc));
     }
 
     template <typename F, typename R, typename ... Args>
     CmdHandler Menu::Insert(const std::string& cmdName, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, Args...) const )
     {
-        return Insert(std::make_unique<VariadicFunctionCommand<F, Args ...>>(cmdName, f, help, parDesc));
+        return Insert(MakeCommand<F, Args ...>(cmdName, f, help, parDesc, detail::IsFuture<R>()));
+    }
+
+    template <typename F, typename R, typename ... Args>
+    CmdHandler Menu::Insert(const std::string& cmdName, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, Completion, Args...) const )
+    {
+        return Insert(std::make_unique<AsyncFunctionCommand<F, Args ...>>(cmdName, f, help, parDesc));
+    }
+
+    template <typename R, typename ... Args>
+    CmdHandler Menu::Insert(const std::string& cmdName, R (*f)(std::ostream&, CancellationToken, Args...), const std::string& help, const std::vector<std::string>& parDesc)
+    {
+        static_assert(detail::IsFuture<R>::value, "a handler taking a CancellationToken must return a std::future");
+        using F = R (*)(std::ostream&, CancellationToken, Args...);
+        return Insert(MakeCancellableCommand<F, Args ...>(cmdName, f, help, parDesc));
+    }
+
+    template <typename F, typename R, typename ... Args>
+    CmdHandler Menu::Insert(const std::string& cmdName, const std::string& help, const std::vector<std::string>& parDesc, F& f, R (F::*)(std::ostream& out, CancellationToken, Args...) const )
+    {
+        static_assert(detail::IsFuture<R>::value, "a handler taking a CancellationToken must return a std::future");
+        return Insert(MakeCancellableCommand<F, Args ...>(cmdName, f, help, parDesc));
+    }
+
+    template <typename F, typename ... Args>
+    std::unique_ptr<Command> Menu::MakeCancellableCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc)
+    {
+        // the command ends when the future returned by f is ready
+        auto g = [f](std::ostream& out, Completion done, Args ... args){ done.Await(f(out, done.Token(), args...)); };
+        return std::make_unique<AsyncFunctionCommand<decltype(g), Args ...>>(name, std::move(g), help, parDesc);
+    }
+
+    template <typename F, typename ... Args>
+    std::unique_ptr<Command> Menu::MakeCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc, std::false_type /*future*/)
+    {
+        return std::make_unique<VariadicFunctionCommand<F, Args ...>>(name, f, help, parDesc);
+    }
+
+    template <typename F, typename ... Args>
+    std::unique_ptr<Command> Menu::MakeCommand(const std::string& name, const F& f, const std::string& help, const std::vector<std::string>& parDesc, std::true_type /*future*/)
+    {
+        // the command ends when the future returned by f is ready
+        auto g = [f](std::ostream& out, Completion done, Args ... args){ done.Await(f(out, args...)); };
+        return std::make_unique<AsyncFunctionCommand<decltype(g), Args ...>>(name, std::move(g), help, parDesc);
     }
 
     template <typename F, typename R>
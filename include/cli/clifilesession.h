@@ -60,10 +60,10 @@ public:
     {
         Enter();
 
+        std::string line; // out of the loop, to reuse its buffer
         while(!exit)
         {
             Prompt();
-            std::string line;
             if (!in.good())
                 Exit();
             std::getline(in, line);
@@ -41,13 +41,15 @@ namespace cli
 
 class Scheduler; // forward declaration
 
+namespace detail
+{
+
 /**
- * @brief CliLocalTerminalSession represents a local session.
- * You should instantiate it to start an interactive prompt on the standard
- * input/output of your application.
- * The handlers of the commands will be invoked in the same thread the @c Scheduler runs. 
+ * @brief GenericCliLocalTerminalSession is the implementation of the local sessions,
+ * parameterized on the keyboard reading the standard input and on the scheduler it needs.
  */
-class CliLocalTerminalSession : public CliSession
+template <typename KEYBOARD, typename SCHEDULER>
+class GenericCliLocalTerminalSession : public CliSession
 {
 public:
 
@@ -60,18 +62,41 @@ public:
      * @param _out the output stream where command output will be printed
      * @param historySize the size of the command history
      */
-    CliLocalTerminalSession(Cli& _cli, Scheduler& scheduler, std::ostream& _out, std::size_t historySize = 100) :
+    GenericCliLocalTerminalSession(Cli& _cli, SCHEDULER& scheduler, std::ostream& _out, std::size_t historySize = 100) :
         CliSession(_cli, _out, historySize),
         kb(scheduler),
         ih(*this, kb)
     {
+        UseScheduler(scheduler);
         Enter();
         Prompt();
     }
 
+protected:
+    void OnCommandCompleted() override
+    {
+        CliSession::OnCommandCompleted();
+        ih.Resume();
+    }
+
 private:
-    detail::Keyboard kb;
-    detail::CommandProcessor<detail::LocalScreen> ih;
+    KEYBOARD kb;
+    CommandProcessor<LocalScreen> ih;
+};
+
+} // namespace detail
+
+/**
+ * @brief CliLocalTerminalSession represents a local session.
+ * You should instantiate it to start an interactive prompt on the standard
+ * input/output of your application.
+ * The handlers of the commands will be invoked in the same thread the @c Scheduler runs. 
+ * The standard input is read by a dedicated thread.
+ */
+class CliLocalTerminalSession : public detail::GenericCliLocalTerminalSession<detail::Keyboard, Scheduler>
+{
+public:
+    using GenericCliLocalTerminalSession::GenericCliLocalTerminalSession;
 };
 
 using CliLocalSession = CliLocalTerminalSession;
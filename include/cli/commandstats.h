@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_COMMANDSTATS_H_
+#define CLI_COMMANDSTATS_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cli
+{
+
+// A histogram of latencies in microseconds, with logarithmic buckets
+// (as in HdrHistogram): the values under 8 have their own bucket,
+// each power of two above is divided in 8 buckets, so that a value
+// is known with an error less than 12.5%.
+// The values above 2^32 us (about 71 minutes) are in the last bucket.
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t SubBuckets = 8;
+    static constexpr unsigned SubBits = 3; // log2(SubBuckets)
+    static constexpr unsigned MaxBits = 32;
+    static constexpr std::size_t Buckets = SubBuckets + (MaxBits - SubBits) * SubBuckets;
+
+    // Returns the index of the bucket of value
+    static std::size_t Bucket(std::uint64_t value)
+    {
+        if (value < SubBuckets)
+            return static_cast<std::size_t>(value);
+        value = std::min<std::uint64_t>(value, (std::uint64_t(1) << MaxBits) - 1);
+        unsigned msb = SubBits;
+        while ((value >> (msb + 1)) != 0)
+            ++msb;
+        const auto sub = static_cast<std::size_t>((value >> (msb - SubBits)) & (SubBuckets - 1));
+        return SubBuckets + (msb - SubBits) * SubBuckets + sub;
+    }
+
+    // Returns the highest value of the bucket with the given index
+    static std::uint64_t BucketHigh(std::size_t index)
+    {
+        if (index < SubBuckets)
+            return index;
+        const auto shift = static_cast<unsigned>((index - SubBuckets) / SubBuckets);
+        const auto sub = (index - SubBuckets) % SubBuckets;
+        const std::uint64_t low = static_cast<std::uint64_t>(SubBuckets + sub) << shift;
+        return low + (std::uint64_t(1) << shift) - 1;
+    }
+
+    void Record(std::uint64_t value) { Add(Bucket(value), 1, value); }
+
+    // Adds count values to the bucket with the given index (max is the highest of them)
+    void Add(std::size_t index, std::uint64_t count, std::uint64_t max)
+    {
+        buckets[index] += count;
+        total += count;
+        if (count != 0) maxValue = std::max(maxValue, max);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (std::size_t i = 0; i < Buckets; ++i)
+            buckets[i] += other.buckets[i];
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    std::uint64_t Count() const { return total; }
+    std::uint64_t Max() const { return maxValue; }
+    std::uint64_t BucketCount(std::size_t index) const { return buckets[index]; }
+
+    // Returns the value not exceeded by the fraction p (in (0, 1]) of the values,
+    // i.e., the highest value of its bucket (or the max value, if lower).
+    // Returns 0 when there are no values.
+    std::uint64_t Percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        auto rank = static_cast<std::uint64_t>(p * static_cast<double>(total) + 0.5);
+        rank = std::max<std::uint64_t>(1, std::min(rank, total));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < Buckets; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+                return std::min(BucketHigh(i), maxValue);
+        }
+        return maxValue;
+    }
+
+private:
+    std::array<std::uint64_t, Buckets> buckets{};
+    std::uint64_t total = 0;
+    std::uint64_t maxValue = 0;
+};
+
+// The statistics of a command
+struct CommandStats
+{
+    std::string command; // the command name, preceded by the names of the submenus
+    std::uint64_t count = 0; // the number of executions
+    std::uint64_t errors = 0; // the executions terminated by an exception
+    LatencyHistogram latency; // microseconds
+};
+
+// The statistics of the commands executed by all the sessions of a Cli
+struct CliStats
+{
+    std::vector<CommandStats> commands; // sorted by command
+    std::uint64_t wrongCommands = 0; // the lines not matching any command
+
+    // Returns the stats of the given command, adding them if missing
+    CommandStats& Command(const std::string& command)
+    {
+        auto i = std::lower_bound(commands.begin(), commands.end(), command,
+            [](const CommandStats& s, const std::string& c){ return s.command < c; });
+        if (i == commands.end() || i->command != command)
+        {
+            i = commands.insert(i, CommandStats{});
+            i->command = command;
+        }
+        return *i;
+    }
+
+    void Merge(const CliStats& other)
+    {
+        for (const auto& s: other.commands)
+        {
+            auto& mine = Command(s.command);
+            mine.count += s.count;
+            mine.errors += s.errors;
+            mine.latency.Merge(s.latency);
+        }
+        wrongCommands += other.wrongCommands;
+    }
+};
+
+} // namespace cli
+
+#endif // CLI_COMMANDSTATS_H_
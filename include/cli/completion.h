@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_COMPLETION_H_
+#define CLI_COMPLETION_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "cancellationtoken.h"
+#include "scheduler.h"
+
+namespace cli
+{
+
+class CliSession; // forward declaration
+
+namespace detail
+{
+
+// The state of an asynchronous command,
+// shared by the session and the copies of its Completion.
+struct AsyncCommand
+{
+    std::mutex mtx;
+    std::condition_variable cv; // notified on completion, when there is no scheduler
+    bool done = false;
+    std::function<void(std::ostream&)> then; // to run in the session, if any
+    // not part of this state, since the tokens are often captured by the
+    // future that the completion holds (e.g., the one of a std::async)
+    std::shared_ptr<CancellationState> cancellation = std::make_shared<CancellationState>();
+
+    // set by the session before starting the command, and then left unchanged:
+    Scheduler* scheduler = nullptr; // where resume is posted on completion (or null)
+    std::function<void()> resume;
+    // only accessed by the thread of the session:
+    CliSession* session = nullptr; // null when the session doesn't wait for the command anymore
+};
+
+template <typename T> struct IsFuture : std::false_type {};
+template <typename T> struct IsFuture<std::future<T>> : std::true_type {};
+
+template <typename T>
+void PrintResult(std::future<T>& f, std::ostream& out) { out << f.get() << '\n'; }
+
+inline void PrintResult(std::future<void>& f, std::ostream& /*out*/) { f.get(); }
+
+} // namespace detail
+
+/**
+ * A `Completion` is passed to the handlers of the asynchronous commands,
+ * i.e. the handlers having it as the second parameter, after the output stream:
+ *
+ *     menu->Insert("load", [](std::ostream&, cli::Completion done, const std::string& file)
+ *     {
+ *         std::thread([done, file]()
+ *         {
+ *             auto n = Load(file);
+ *             done([n](std::ostream& out){ out << n << " records loaded\n"; });
+ *         }).detach();
+ *     });
+ *
+ * The handler returns without waiting, and the session shows the prompt
+ * again only when the `Completion` is invoked (from any thread).
+ * Meanwhile, the scheduler is free to serve the other sessions.
+ * The output stream passed to the handler must be used only before returning:
+ * the output at the end goes in the function passed to the `Completion`,
+ * that is run by the session (and can throw, like the handlers).
+ *
+ * Only the first invocation of a `Completion` (or of one of its copies) counts.
+ * If the command is interrupted (see `Token`), the invocation is ignored.
+ */
+class Completion
+{
+public:
+    explicit Completion(std::shared_ptr<detail::AsyncCommand> _state) : state(std::move(_state)) {}
+
+    /// Ends the command.
+    void operator()() const { Complete({}); }
+
+    /// Ends the command, running @c then with the output stream of the session.
+    void operator()(std::function<void(std::ostream&)> then) const { Complete(std::move(then)); }
+
+    /// Returns the token cancelled when the user interrupts the command
+    /// (or the session ends before its completion).
+    CancellationToken Token() const { return CancellationToken(state->cancellation); }
+
+    /// Ends the command when the future is ready,
+    /// printing its value (if not void) or handling its exception.
+    /// The future is polled by the scheduler of the session, if any,
+    /// backing off up to 10 ms (so, its end is noticed with some delay).
+    /// The polling stops when the session doesn't wait for the command anymore.
+    /// It must be called in the thread of the session (e.g., by the handler).
+    template <typename T>
+    void Await(std::future<T> f) const
+    {
+        Poll(std::make_shared<std::future<T>>(std::move(f)), std::chrono::milliseconds(1));
+    }
+
+private:
+
+    void Complete(std::function<void(std::ostream&)> then) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->mtx);
+            if (state->done)
+                return;
+            state->done = true;
+            state->then = std::move(then);
+        }
+        if (state->scheduler)
+            state->scheduler->Post(state->resume);
+        else
+            state->cv.notify_all();
+    }
+
+    template <typename T>
+    void Poll(const std::shared_ptr<std::future<T>>& f, Scheduler::Clock::duration interval) const
+    {
+        if (state->scheduler == nullptr)
+            f->wait(); // the session is waiting anyway
+        else if (f->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (state->session == nullptr)
+            {
+                // cancelled (or the session is gone): nobody waits for the future,
+                // but the destructor of the future of a std::async blocks until
+                // the end of its task, so it's left to a thread instead of the scheduler
+                std::thread([f](){ f->wait(); }).detach();
+                return;
+            }
+            // check again later, backing off up to 10 ms
+            const Completion self(*this);
+            const auto next = std::min<Scheduler::Clock::duration>(interval * 2, std::chrono::milliseconds(10));
+            state->scheduler->PostAfter(interval, [self, f, next](){ self.Poll(f, next); });
+            return;
+        }
+        Complete([f](std::ostream& out){ detail::PrintResult(*f, out); });
+    }
+
+    std::shared_ptr<detail::AsyncCommand> state;
+};
+
+} // namespace cli
+
+#endif // CLI_COMPLETION_H_
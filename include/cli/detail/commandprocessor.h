@@ -30,6 +30,7 @@
 #ifndef CLI_DETAIL_COMMANDPROCESSOR_H_
 #define CLI_DETAIL_COMMANDPROCESSOR_H_
 
+#include <deque>
 #include <functional>
 #include <string>
 #include "terminal.h"
@@ -67,7 +68,30 @@ public:
         terminal(session.OutStream()),
         kb(_kb)
     {
-        kb.Register( [this](auto key){ this->Keypressed(key); } );
+        kb.Register(
+            [this](auto key){ this->Keypressed(key); },
+            [this](const char* text, std::size_t size){ this->TextInserted(text, size); }
+        );
+    }
+
+    /**
+     * @brief Process the input received while the session was busy.
+     *
+     * The session must call it when an asynchronous command completes
+     * (see CliSession::OnCommandCompleted).
+     */
+    void Resume()
+    {
+        // a command replayed can be asynchronous, too: the rest waits for it
+        while (!typeAhead.empty() && !session.Busy())
+        {
+            const Input input = std::move(typeAhead.front());
+            typeAhead.pop_front();
+            if (input.text.empty())
+                Keypressed(input.key);
+            else
+                TextInserted(input.text.data(), input.text.size());
+        }
     }
 
 private:
@@ -79,10 +103,107 @@ private:
      */
     void Keypressed(std::pair<KeyType, char> k)
     {
+        if (session.Busy())
+        {
+            // while an asynchronous command runs, eof and interrupt are handled
+            // right away, and the rest is processed when the command completes
+            if (k.first == KeyType::eof)
+                session.Exit();
+            else if (k.first == KeyType::interrupt)
+            {
+                typeAhead.clear(); // like a terminal does
+                session.OutStream() << "^C\r\n";
+                session.Interrupt();
+            }
+            else if (typeAhead.size() < maxTypeAhead)
+                typeAhead.push_back(Input{ k, std::string() });
+            return;
+        }
+        if (searching && SearchKeypressed(k))
+            return;
         const std::pair<Symbol,std::string> s = terminal.Keypressed(k);
         NewCommand(s);
     }
 
+    /**
+     * @brief Handle a run of text typed at once.
+     *
+     * @param text The text inserted.
+     * @param size The length of the text.
+     */
+    void TextInserted(const char* text, std::size_t size)
+    {
+        if (session.Busy())
+        {
+            if (typeAhead.size() < maxTypeAhead)
+                typeAhead.push_back(Input{ std::make_pair(KeyType::ignored, ' '), std::string(text, size) });
+            return;
+        }
+        if (searching)
+        {
+            query.append(text, size);
+            Search(matchIndex);
+        }
+        else
+            terminal.InsertText(text, size);
+    }
+
+    /**
+     * @brief Handle a keypress event in reverse incremental search mode.
+     *
+     * @param k The key that was pressed.
+     * @return false if the key ends the search, and must be processed as usual.
+     */
+    bool SearchKeypressed(std::pair<KeyType, char> k)
+    {
+        switch (k.first)
+        {
+            case KeyType::search: // the next match
+                Search(matchIndex + 1);
+                return true;
+            case KeyType::backspace:
+                if (!query.empty())
+                    query.pop_back();
+                Search(0);
+                return true;
+            case KeyType::ascii:
+                if (k.second != '\t')
+                {
+                    query += k.second;
+                    Search(matchIndex);
+                    return true;
+                }
+                break;
+            case KeyType::interrupt: // discards the line
+                searching = false;
+                return false;
+            default:
+                break;
+        }
+        // any other key accepts the match
+        searching = false;
+        terminal.SetLine(match);
+        return false;
+    }
+
+    /**
+     * @brief Search the query in the history, starting from the given index,
+     * and show the result.
+     *
+     * @param from The index of the first command to consider (0 is the newest).
+     */
+    void Search(std::size_t from)
+    {
+        std::string cmd;
+        const bool found = session.SearchCmd(query, from, cmd);
+        if (found)
+        {
+            matchIndex = from;
+            match = cmd;
+        }
+        terminal.SetLine(std::string(found ? "(reverse-i-search)`" : "(failed reverse-i-search)`") + query + "': " + match);
+    }
+
     /**
      * @brief Process a new command.
      *
@@ -101,8 +222,16 @@ private:
                 session.Exit();
                 break;
             }
+            case Symbol::interrupt:
+            {
+                session.Prompt();
+                break;
+            }
             case Symbol::command:
             {
+                // a synchronous handler blocks the scheduler, so it can't get the interrupt key:
+                // the keyboard is deactivated meanwhile, and Ctrl-C raises SIGINT
+                // (an asynchronous command returns right away, and can be interrupted)
                 kb.DeactivateInput();
                 session.Feed(s.second);
                 session.Prompt();
@@ -148,6 +277,15 @@ private:
                 terminal.SetLine( line );
                 break;
             }
+            case Symbol::search:
+            {
+                searching = true;
+                query.clear();
+                matchIndex = 0;
+                match = terminal.GetLine(); // kept if nothing is found
+                terminal.SetLine("(reverse-i-search)`': " + match);
+                break;
+            }
             case Symbol::clear:
             {
                 const auto currentLine = terminal.GetLine();
@@ -164,6 +302,21 @@ private:
     CliSession& session;
     Terminal<SCREEN> terminal;
     InputDevice& kb;
+
+    // the input received while the session is busy (a key, or a text if not empty)
+    struct Input
+    {
+        std::pair<KeyType, char> key;
+        std::string text;
+    };
+    static constexpr std::size_t maxTypeAhead = 1024; // the input beyond is dropped
+    std::deque<Input> typeAhead;
+
+    // reverse incremental search (ctrl+R)
+    bool searching = false;
+    std::string query;
+    std::size_t matchIndex = 0; // the index in the history of match
+    std::string match;
 };
 
 } // namespace detail
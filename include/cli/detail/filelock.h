@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_FILELOCK_H_
+#define CLI_DETAIL_FILELOCK_H_
+
+#include <string>
+#include "platform.h"
+
+#if defined(CLI_OS_WIN)
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
+#endif
+
+namespace cli
+{
+namespace detail
+{
+
+// An advisory lock on a file (created if it doesn't exist), held until
+// the object is destroyed: it excludes the other processes using
+// the same lock file, not the other threads of the process.
+// If the file can't be opened or locked, Locked() returns false.
+class FileLock
+{
+public:
+    enum class Mode { shared, exclusive };
+
+    FileLock(const std::string& fileName, Mode mode)
+    {
+#if defined(CLI_OS_WIN)
+        handle = ::CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return;
+        OVERLAPPED overlapped{};
+        const DWORD flags = (mode == Mode::exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0);
+        locked = (::LockFileEx(handle, flags, 0, MAXDWORD, MAXDWORD, &overlapped) != 0);
+#else
+        fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (fd < 0)
+            return;
+        const int operation = (mode == Mode::exclusive ? LOCK_EX : LOCK_SH);
+        int result = 0;
+        do
+            result = ::flock(fd, operation);
+        while (result != 0 && errno == EINTR);
+        locked = (result == 0);
+#endif
+    }
+
+    ~FileLock()
+    {
+#if defined(CLI_OS_WIN)
+        if (handle != INVALID_HANDLE_VALUE)
+            ::CloseHandle(handle); // releases the lock
+#else
+        if (fd >= 0)
+            ::close(fd); // releases the lock
+#endif
+    }
+
+    // non copyable
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool Locked() const { return locked; }
+
+private:
+#if defined(CLI_OS_WIN)
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+    bool locked = false;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_FILELOCK_H_
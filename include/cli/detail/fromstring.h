@@ -32,6 +32,10 @@
 
 // #define CLI_FROMSTRING_USE_BOOST
 
+// detail::try_from_string converts a string into a value of type T without
+// throwing: it returns false when the string can't be interpreted as a T.
+// detail::from_string is built on top of it and throws on failure.
+
 #ifdef CLI_FROMSTRING_USE_BOOST
 
 #include <boost/lexical_cast.hpp>
@@ -41,6 +45,13 @@ namespace cli
 namespace detail
 {
 
+template <typename T>
+inline
+bool try_from_string(const std::string& s, T& value)
+{
+    return boost::conversion::try_lexical_convert(s, value);
+}
+
 template <typename T>
 inline
 T from_string(const std::string& s)
@@ -53,10 +64,30 @@ T from_string(const std::string& s)
 
 #else
 
+#include <cctype>
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <limits>
 #include <string>
 #include <sstream>
+#include <type_traits>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    #if defined(__has_include)
+        #if __has_include(<charconv>)
+            #include <charconv>
+        #endif
+    #endif
+#endif
+
+// std::from_chars is locale independent and doesn't allocate:
+// use it when the standard library provides the complete implementation
+#if defined(__cpp_lib_to_chars)
+    #define CLI_FROMSTRING_USE_FROM_CHARS
+#endif
 
 namespace cli
 {
@@ -72,204 +103,262 @@ namespace cli
                 }
         };
 
-template <typename T>
-inline T from_string(const std::string& s);
+namespace detail
+{
 
-template <>
-inline std::string from_string(const std::string& s)
+// skip the optional '+' sign (from_chars doesn't accept it)
+inline const char* skip_plus(const char* first, const char* last)
 {
-    return s;
+    if (first != last && *first == '+')
+    {
+        ++first;
+        // "+-1" and "++1" are not numbers
+        if (first != last && (*first == '+' || *first == '-'))
+            return nullptr;
+    }
+    return first;
 }
 
-template <>
-inline std::nullptr_t from_string(const std::string& /*s*/)
+// The floating point numbers are accepted as std::strtod does in the "C" locale
+// (as the original implementation, based on std::stod): in decimal or
+// hexadecimal ("0x" prefix) notation, or infinity and nan.
+// Both the implementations accept the same strings.
+
+// returns the position after the "0x" prefix of [first, last), or nullptr
+inline const char* skip_hex_prefix(const char* first, const char* last)
 {
+    if (last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+        return first + 2;
     return nullptr;
 }
 
-namespace detail
+#ifdef CLI_FROMSTRING_USE_FROM_CHARS
+
+template <typename T>
+inline bool number_from_string(const std::string& s, T& value)
 {
+    const char* last = s.data() + s.size();
+    const char* first = skip_plus(s.data(), last);
+    if (first == nullptr || first == last)
+        return false;
+    T result{};
+    const auto r = std::from_chars(first, last, result);
+    if (r.ec != std::errc() || r.ptr != last)
+        return false;
+    value = result;
+    return true;
+}
+
+template <typename T>
+inline bool unsigned_from_string(const std::string& s, T& value) { return number_from_string(s, value); }
 
 template <typename T>
-inline T unsigned_digits_from_string(const std::string& s)
+inline bool signed_from_string(const std::string& s, T& value) { return number_from_string(s, value); }
+
+template <typename T>
+inline bool floating_from_string(const std::string& s, T& value)
 {
-    if (s.empty())
-        throw bad_conversion();
+    // from_chars accepts infinity and nan, but not the "0x" prefix of the hexadecimal notation
+    const char* last = s.data() + s.size();
+    const char* first = skip_plus(s.data(), last);
+    if (first == nullptr || first == last)
+        return false;
+    const bool negative = (*first == '-');
+    const char* digits = skip_hex_prefix(negative ? first+1 : first, last);
+    if (digits == nullptr)
+        return number_from_string(s, value);
+    // from_chars would accept the sign also after the prefix
+    if (*digits == '+' || *digits == '-')
+        return false;
+    T result{};
+    const auto r = std::from_chars(digits, last, result, std::chars_format::hex);
+    if (r.ec != std::errc() || r.ptr != last)
+        return false;
+    value = negative ? -result : result;
+    return true;
+}
+
+#else
+
+template <typename T>
+inline bool unsigned_digits_from_string(const char* first, const char* last, T& value)
+{
+    if (first == last)
+        return false;
     T result = 0;
-    for (char c: s)
+    for (; first != last; ++first)
     {
-        if (!std::isdigit(c))
-            throw bad_conversion();
+        const char c = *first;
+        if (c < '0' || c > '9')
+            return false;
         const T digit = static_cast<T>( c - '0' );
-        const T tmp = (result * 10) + digit;
-        if (result != ((tmp-digit)/10) || (tmp < result))
-            throw bad_conversion();
-        result = tmp;
+        if (result > (std::numeric_limits<T>::max() - digit) / 10)
+            return false;
+        result = static_cast<T>( result * 10 + digit );
     }
-    return result;
+    value = result;
+    return true;
 }
 
 template <typename T>
-inline T unsigned_from_string(std::string s)
+inline bool unsigned_from_string(const std::string& s, T& value)
 {
-    if (s.empty())
-        throw bad_conversion();
-    if (s[0] == '+')
-    {
-        s = s.substr(1);
-    }
-    return unsigned_digits_from_string<T>(s);
+    const char* last = s.data() + s.size();
+    const char* first = skip_plus(s.data(), last);
+    if (first == nullptr)
+        return false;
+    return unsigned_digits_from_string(first, last, value);
 }
 
 template <typename T>
-inline T signed_from_string(std::string s)
+inline bool signed_from_string(const std::string& s, T& value)
 {
-    if (s.empty())
-        throw bad_conversion();
     using U = std::make_unsigned_t<T>;
-    if (s[0] == '-')
+    const char* first = s.data();
+    const char* last = first + s.size();
+    U val = 0;
+    if (first != last && *first == '-')
     {
-        s = s.substr(1);
-        const U val = unsigned_digits_from_string<U>(s);
-        auto min = std::numeric_limits<T>::min(); // this to avoid overflow warnings. Please NOTE: const auto produces warning!
-        if ( val > static_cast<U>( - min ) )
-            throw bad_conversion();
-        return (- static_cast<T>(val));
+        if (!unsigned_digits_from_string(first+1, last, val))
+            return false;
+        const U maxNeg = static_cast<U>( static_cast<U>(std::numeric_limits<T>::max()) + 1 );
+        if (val > maxNeg)
+            return false;
+        // two's complement negation, done in the unsigned type to avoid overflow on min()
+        value = static_cast<T>( static_cast<U>( U(0) - val ) );
+        return true;
     }
-    else if (s[0] == '+')
-    {
-        s = s.substr(1);
-    }
-    const U val = unsigned_digits_from_string<U>(s);
+    first = skip_plus(first, last);
+    if (first == nullptr || !unsigned_digits_from_string(first, last, val))
+        return false;
     if (val > static_cast<U>( std::numeric_limits<T>::max() ))
-        throw bad_conversion();
-    return static_cast<T>(val);
+        return false;
+    value = static_cast<T>(val);
+    return true;
 }
 
-} // namespace detail
+inline float strto(const char* s, char** end, float) { return std::strtof(s, end); }
+inline double strto(const char* s, char** end, double) { return std::strtod(s, end); }
+inline long double strto(const char* s, char** end, long double) { return std::strtold(s, end); }
 
-// signed
+template <typename T>
+inline bool floating_from_string(const std::string& s, T& value)
+{
+    // strto* skip the leading white spaces
+    if ( s.empty() || std::isspace(static_cast<unsigned char>(s[0])) )
+        return false;
+    // strto* use the decimal point of the current locale:
+    // translate the '.' into it, so that the result doesn't depend on the locale
+    std::string localized;
+    const std::string* source = &s;
+    const char* point = std::localeconv()->decimal_point;
+    if (std::strcmp(point, ".") != 0)
+    {
+        if (s.find(point) != std::string::npos)
+            return false;
+        for (char c: s)
+        {
+            if (c == '.') localized += point;
+            else localized += c;
+        }
+        source = &localized;
+    }
+    const char* first = source->c_str();
+    char* end = nullptr;
+    const int savedErrno = errno;
+    errno = 0;
+    const T result = strto(first, &end, T{});
+    const bool outOfRange = (errno == ERANGE);
+    errno = savedErrno;
+    if (outOfRange || end != first + source->size())
+        return false;
+    value = result;
+    return true;
+}
 
-template <> inline signed char 
-from_string(const std::string& s) { return detail::signed_from_string<signed char>(s); }
+#endif // CLI_FROMSTRING_USE_FROM_CHARS
 
-template <> inline short int 
-from_string(const std::string& s) { return detail::signed_from_string<short int>(s); }
+} // namespace detail
 
-template <> inline int
-from_string(const std::string& s) { return detail::signed_from_string<int>(s); }
+// fallback: operator >>
+
+template <typename T>
+inline bool try_from_string(const std::string& s, T& value)
+{
+    std::stringstream interpreter;
+    T result;
 
-template <> inline long int
-from_string(const std::string& s) { return detail::signed_from_string<long int>(s); }
+    if(!(interpreter << s) ||
+        !(interpreter >> result) ||
+        !(interpreter >> std::ws).eof())
+        return false;
 
-template <> inline long long int
-from_string(const std::string& s) { return detail::signed_from_string<long long int>(s); }
+    value = std::move(result);
+    return true;
+}
 
-// unsigned
+inline bool try_from_string(const std::string& s, std::string& value)
+{
+    value = s;
+    return true;
+}
 
-template <> inline unsigned char
-from_string(const std::string& s) { return detail::unsigned_from_string<unsigned char>(s); }
+inline bool try_from_string(const std::string& /*s*/, std::nullptr_t& value)
+{
+    value = nullptr;
+    return true;
+}
 
-template <> inline unsigned short int
-from_string(const std::string& s) { return detail::unsigned_from_string<unsigned short int>(s); }
+// signed
 
-template <> inline unsigned int
-from_string(const std::string& s) { return detail::unsigned_from_string<unsigned int>(s); }
+inline bool try_from_string(const std::string& s, signed char& value) { return detail::signed_from_string(s, value); }
+inline bool try_from_string(const std::string& s, short int& value) { return detail::signed_from_string(s, value); }
+inline bool try_from_string(const std::string& s, int& value) { return detail::signed_from_string(s, value); }
+inline bool try_from_string(const std::string& s, long int& value) { return detail::signed_from_string(s, value); }
+inline bool try_from_string(const std::string& s, long long int& value) { return detail::signed_from_string(s, value); }
 
-template <> inline unsigned long int
-from_string(const std::string& s) { return detail::unsigned_from_string<unsigned long int>(s); }
+// unsigned
 
-template <> inline unsigned long long int
-from_string(const std::string& s) { return detail::unsigned_from_string<unsigned long long int>(s); }
+inline bool try_from_string(const std::string& s, unsigned char& value) { return detail::unsigned_from_string(s, value); }
+inline bool try_from_string(const std::string& s, unsigned short int& value) { return detail::unsigned_from_string(s, value); }
+inline bool try_from_string(const std::string& s, unsigned int& value) { return detail::unsigned_from_string(s, value); }
+inline bool try_from_string(const std::string& s, unsigned long int& value) { return detail::unsigned_from_string(s, value); }
+inline bool try_from_string(const std::string& s, unsigned long long int& value) { return detail::unsigned_from_string(s, value); }
 
 // bool
 
-template <>
-inline bool from_string(const std::string& s)
+inline bool try_from_string(const std::string& s, bool& value)
 {
-    if (s == "true") return true;
-    else if (s == "false") return false;
-    const auto value = detail::signed_from_string<long long int>(s);
-    if (value == 1) return true;
-    else if (value == 0) return false;
-    throw bad_conversion();            
+    if (s == "true") { value = true; return true; }
+    if (s == "false") { value = false; return true; }
+    long long int n = 0;
+    if (!detail::signed_from_string(s, n) || (n != 0 && n != 1))
+        return false;
+    value = (n == 1);
+    return true;
 }
 
 // chars
 
-template <>
-inline char from_string(const std::string& s)
+inline bool try_from_string(const std::string& s, char& value)
 {
-    if (s.size() != 1) throw bad_conversion();
-    return s[0];            
+    if (s.size() != 1) return false;
+    value = s[0];
+    return true;
 }
 
 // floating points
 
-template <>
-inline float from_string(const std::string& s)
-{
-    if ( std::any_of(s.begin(), s.end(), [](char c){return std::isspace(c);} ) )
-        throw bad_conversion();
-    std::string::size_type sz;
-    float result = {};
-    try {
-        result = std::stof(s, &sz);
-    } catch (const std::exception&) {
-        throw bad_conversion();
-    }
-    if (sz != s.size())
-        throw bad_conversion();
-    return result;
-}
-
-template <>
-inline double from_string(const std::string& s)
-{
-    if ( std::any_of(s.begin(), s.end(), [](char c){return std::isspace(c);} ) )
-        throw bad_conversion();
-    std::string::size_type sz;
-    double result = {};
-    try {
-        result = std::stod(s, &sz);
-    } catch (const std::exception&) {
-        throw bad_conversion();
-    }
-    if (sz != s.size())
-        throw bad_conversion();
-    return result;
-}
-
-template <>
-inline long double from_string(const std::string& s)
-{
-    if ( std::any_of(s.begin(), s.end(), [](char c){return std::isspace(c);} ) )
-        throw bad_conversion();
-    std::string::size_type sz;
-    long double result = {};
-    try {
-        result = std::stold(s, &sz);
-    } catch (const std::exception&) {
-        throw bad_conversion();
-    }
-    if (sz != s.size())
-        throw bad_conversion();
-    return result;
-}
-
-// fallback: operator <<
+inline bool try_from_string(const std::string& s, float& value) { return detail::floating_from_string(s, value); }
+inline bool try_from_string(const std::string& s, double& value) { return detail::floating_from_string(s, value); }
+inline bool try_from_string(const std::string& s, long double& value) { return detail::floating_from_string(s, value); }
 
 template <typename T>
 inline T from_string(const std::string& s)
 {
-    std::stringstream interpreter;
-    T result;
-
-    if(!(interpreter << s) ||
-        !(interpreter >> result) ||
-        !(interpreter >> std::ws).eof())
+    T result{};
+    if (!try_from_string(s, result))
         throw bad_conversion();
-
     return result;
 }
 
@@ -277,7 +366,6 @@ inline T from_string(const std::string& s)
 
 } // namespace cli
 
-
 #endif // CLI_FROMSTRING_USE_BOOST
 
 #endif // CLI_DETAIL_FROMSTRING_H_
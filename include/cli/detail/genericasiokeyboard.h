@@ -0,0 +1,211 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_GENERICASIOKEYBOARD_H_
+#define CLI_DETAIL_GENERICASIOKEYBOARD_H_
+
+#include "platform.h"
+
+#if !defined(CLI_OS_LINUX) && !defined(CLI_OS_MAC)
+    #error "GenericAsioKeyboard is available only on POSIX platforms."
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "genericasioscheduler.h"
+#include "inputdevice.h"
+#include "keydecoder.h"
+#include "telnetscanner.h"
+
+namespace cli
+{
+namespace detail
+{
+
+// A keyboard reading the standard input asynchronously, in the thread
+// running the asio scheduler (it needs no threads of its own).
+template <typename ASIOLIB>
+class GenericAsioKeyboard : public InputDevice
+{
+public:
+    explicit GenericAsioKeyboard(GenericAsioScheduler<ASIOLIB>& _scheduler) :
+        InputDevice(_scheduler),
+        input(_scheduler.AsioContext(), OpenInput())
+    {
+        ActivateInputImpl();
+    }
+    ~GenericAsioKeyboard() override
+    {
+        ToStandardMode();
+        asiolibec::error_code ec;
+        input.close(ec);
+    }
+
+    // non copyable
+    GenericAsioKeyboard(const GenericAsioKeyboard&) = delete;
+    GenericAsioKeyboard& operator=(const GenericAsioKeyboard&) = delete;
+
+    // these methods must be called in the thread running the scheduler
+    void ActivateInput() override
+    {
+        ActivateInputImpl();
+    }
+    void DeactivateInput() override
+    {
+        enabled = false;
+        asiolibec::error_code ec;
+        input.cancel(ec);
+        // the standard input can be used in blocking mode while deactivated
+        input.native_non_blocking(false, ec);
+        ToStandardMode();
+    }
+
+private:
+
+    // Returns a new descriptor reading the standard input.
+    // asio makes it non blocking, and the flag belongs to the open file:
+    // with a dup, it would be shared with the standard output on the same terminal,
+    // whose writes could fail with EAGAIN. So, a terminal is opened again.
+    static int OpenInput()
+    {
+        char name[256];
+        if (::isatty(STDIN_FILENO) && ::ttyname_r(STDIN_FILENO, name, sizeof(name)) == 0)
+        {
+            const int fd = ::open(name, O_RDONLY | O_NOCTTY);
+            if (fd >= 0)
+                return fd;
+        }
+        return ::dup(STDIN_FILENO);
+    }
+
+    // we need a private non virtual method to call from the constructor
+    void ActivateInputImpl()
+    {
+        ToManualMode();
+        enabled = true;
+        if (!reading) // otherwise, the cancelled read will restart
+            Read();
+    }
+
+    void Read()
+    {
+        reading = true;
+        input.async_read_some(
+            asiolib::buffer(buffer, sizeof(buffer)),
+            [this, alive = std::weak_ptr<bool>(alive)](const asiolibec::error_code& ec, std::size_t size)
+            {
+                if (!alive.expired()) // the cancelled read can complete after the destruction
+                    OnRead(ec, size);
+            }
+        );
+    }
+
+    void OnRead(const asiolibec::error_code& ec, std::size_t size)
+    {
+        reading = false;
+        if (ec == asiolib::error::operation_aborted)
+        {
+            // cancelled by DeactivateInput, but maybe it has been activated again
+            if (enabled)
+                Read();
+            return;
+        }
+        if (ec)
+        {
+            // the standard input has been closed
+            Notify(std::make_pair(KeyType::eof, ' '));
+            return;
+        }
+
+        const char* data = buffer;
+        const char* end = buffer + size;
+        while (data != end)
+        {
+            // the printable chars read at once (e.g., pasted) are notified as a whole
+            const char* runEnd = decoder.Idle() ? FindTelnetSpecial(data, end) : data;
+            if (runEnd != data)
+            {
+                Notify(data, static_cast<std::size_t>(runEnd - data));
+                data = runEnd;
+            }
+            else
+            {
+                std::pair<KeyType,char> key;
+                if (decoder.Feed(*data++, key))
+                    Notify(key);
+            }
+        }
+
+        if (enabled)
+            Read();
+    }
+
+    void ToManualMode()
+    {
+        constexpr tcflag_t ICANON_FLAG = ICANON;
+        constexpr tcflag_t ECHO_FLAG = ECHO;
+
+        if (manualMode) return; // otherwise, oldt would lose the standard settings
+        tcgetattr(STDIN_FILENO, &oldt);
+        newt = oldt;
+        newt.c_lflag &= ~( ICANON_FLAG | ECHO_FLAG );
+        // ctrl+C is read as a key, instead of raising SIGINT, only while the input is active
+        // (i.e., the session is idle or runs an asynchronous command):
+        // the standard mode raises SIGINT again while a synchronous handler runs
+        newt.c_cc[VINTR] = _POSIX_VDISABLE;
+        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+        manualMode = true;
+    }
+
+    void ToStandardMode()
+    {
+        if (!manualMode) return;
+        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+        manualMode = false;
+    }
+
+    asiolib::posix::stream_descriptor input;
+    KeyDecoder decoder;
+    char buffer[256];
+    bool enabled = false;
+    bool reading = false; // an async read is pending
+    termios oldt;
+    termios newt;
+    bool manualMode = false;
+    std::shared_ptr<bool> alive = std::make_shared<bool>(true);
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_GENERICASIOKEYBOARD_H_
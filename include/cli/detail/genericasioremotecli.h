@@ -30,13 +30,19 @@
 #ifndef CLI_DETAIL_GENERICASIOREMOTECLI_H_
 #define CLI_DETAIL_GENERICASIOREMOTECLI_H_
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "../cli.h"
 #include "commandprocessor.h"
 #include "server.h"
 #include "inputdevice.h"
 #include "genericasioscheduler.h"
 #include "screen.h"
+#include "telnettrace.h"
+#include "telnetscanner.h"
 
 namespace cli
 {
@@ -48,21 +54,30 @@ namespace detail
 class TelnetSession : public Session
 {
 public:
-    explicit TelnetSession(asiolib::ip::tcp::socket _socket) :
-        Session(std::move(_socket))
+    TelnetSession(asiolib::ip::tcp::socket _socket, Scheduler& _scheduler) :
+        Session(std::move(_socket), _scheduler)
     {}
 
+    // records the protocol events of this session in _trace
+    void Trace(std::shared_ptr<TelnetTrace> _trace)
+    {
+        trace = std::move(_trace);
+        if (trace) traceId = trace->NewSession();
+    }
+
 protected:
 
-    std::string Encode(const std::string& _data) const override
+    void Encode(const char* _data, std::size_t size, std::string& out) const override
     {
-        std::string result;
-        for (char c: _data)
+        const char* const last = _data + size;
+        while (_data != last)
         {
-            if (c == '\n') result += '\r';
-            result += c;
+            const char* nl = std::find(_data, last, '\n');
+            out.append(_data, nl);
+            if (nl == last) break;
+            out += "\r\n";
+            _data = nl + 1;
         }
-        return result;
     }
 
     void OnConnect() override
@@ -98,75 +113,6 @@ protected:
     }
     void OnDisconnect() override {}
     void OnError() override {}
-#if 0
-    void OnDataReceived(const std::string& data) override
-    {
-        if (waitAck)
-        {
-            if ( data[0] == '\x0FF' )
-            {
-                // TODO
-                for (size_t i = 0; i < data.size(); ++i)
-                    std::cout << static_cast<int>( data[i] & 0xFF ) << ' ';
-                std::cout << std::endl;
-
-                for (size_t i = 0; i < data.size(); ++i)
-                    std::cout << "0x" << std::hex << static_cast<int>( data[i] & 0xFF ) << std::dec << ' ';
-                std::cout << std::endl;
-
-                for (size_t i = 0; i < data.size(); ++i)
-                    switch (static_cast<int>( data[i] & 0xFF ))
-                    {
-                        case 0xFF: std::cout << "IAC "; break;
-                        case 0xFE: std::cout << "DONT "; break;
-                        case 0xFD: std::cout << "DO "; break;
-                        case 0xFC: std::cout << "WONT "; break;
-                        case 0xFB: std::cout << "WILL "; break;
-                        case 0xFA: std::cout << "SB "; break;
-                        case 0xF9: std::cout << "GoAhead "; break;
-                        case 0xF8: std::cout << "EraseLine "; break;
-                        case 0xF7: std::cout << "EraseCharacter "; break;
-                        case 0xF6: std::cout << "AreYouThere "; break;
-                        case 0xF5: std::cout << "AbortOutput "; break;
-                        case 0xF4: std::cout << "InterruptProcess "; break;
-                        case 0xF3: std::cout << "Break "; break;
-                        case 0xF2: std::cout << "DataMark "; break;
-                        case 0xF1: std::cout << "NOP "; break;
-                        case 0xF0: std::cout << "SE "; break;
-                        default: std::cout << (static_cast<int>( data[i] & 0xFF )) << ' ';
-                    }
-                std::cout << std::endl;
-
-            }
-            waitAck = false;
-/*
-            std::string iacWillSuppressGoAhead{ "\x0FF\x0FB\x003", 3 };
-            if ( data == iacWillSuppressGoAhead )
-            {
-                waitAck = false;
-                cliSession.Prompt();
-            }
-
-            else
-                Disconnect();
-*/
-        }
-        else
-        {
-            for (size_t i = 0; i < data.size(); ++i)
-                Feed(data[i]);
-/*
-            auto str = data;
-            // trim trailing spaces
-            std::size_t endpos = str.find_last_not_of(" \t\r\n");
-            if( std::string::npos != endpos ) str = str.substr( 0, endpos+1 );
-
-            if ( cliSession.Feed( str ) ) cliSession.Prompt();
-            else Disconnect();
-*/
-        }
-    }
-#else
 
     /*
     See
@@ -220,8 +166,26 @@ protected:
 
     void OnDataReceived(const std::string& _data) override
     {
-        for (char c: _data)
-            Consume(c);
+        const char* c = _data.data();
+        const char* const last = c + _data.size();
+        while (c != last)
+        {
+            if (state == State::data && !escape)
+            {
+                // the text up to the next special char goes to the output as a whole
+                const char* runEnd = FindTelnetSpecial(c, last);
+                if (runEnd != c)
+                {
+                    if (trace)
+                        for (const char* i = c; i != runEnd; ++i)
+                            Record(TelnetTrace::Event::data, *i);
+                    Output(c, static_cast<std::size_t>(runEnd - c));
+                    c = runEnd;
+                    continue;
+                }
+            }
+            Consume(*c++);
+        }
     }
 
 private:
@@ -250,6 +214,7 @@ private:
         switch(state)
         {
             case State::data:
+                Record(TelnetTrace::Event::data, c);
                 Output(c);
                 break;
             case State::sub:
@@ -276,39 +241,21 @@ private:
 
     void Command(char c)
     {
-/*
-        switch (static_cast<int>( c & 0xFF ))
-        {
-            case 0xFF: std::cout << "IAC" << std::endl; break;
-            case 0xFE: std::cout << "DONT" << std::endl; break;
-            case 0xFD: std::cout << "DO" << std::endl; break;
-            case 0xFC: std::cout << "WONT" << std::endl; break;
-            case 0xFB: std::cout << "WILL" << std::endl; break;
-            case 0xFA: std::cout << "SB" << std::endl; break;
-            case 0xF9: std::cout << "GoAhead" << std::endl; break;
-            case 0xF8: std::cout << "EraseLine" << std::endl; break;
-            case 0xF7: std::cout << "EraseCharacter" << std::endl; break;
-            case 0xF6: std::cout << "AreYouThere" << std::endl; break;
-            case 0xF5: std::cout << "AbortOutput" << std::endl; break;
-            case 0xF4: std::cout << "InterruptProcess" << std::endl; break;
-            case 0xF3: std::cout << "Break" << std::endl; break;
-            case 0xF2: std::cout << "DataMark" << std::endl; break;
-            case 0xF1: std::cout << "NOP" << std::endl; break;
-            case 0xF0: std::cout << "SE" << std::endl; break;
-            default: std::cout << (static_cast<int>( c & 0xFF )) << std::endl;;
-        }
-*/
+        Record(TelnetTrace::Event::command, c);
         switch(c)
         {
             case SE:
                 if (state == State::sub)
                     state = State::data;
-                else
-                    std::cerr << "ERROR: received SE when not in sub state\n";
+                else // received SE when not in sub state
+                    Record(TelnetTrace::Event::error, c);
+                break;
+            case InterruptProcess:
+                OnInterrupt();
+                state = State::data;
                 break;
             case DataMark: // ?
             case Break: // ?
-            case InterruptProcess:
             case AbortOutput:
             case AreYouThere:
             case EraseCharacter:
@@ -320,8 +267,8 @@ private:
             case SB:
                 if (state != State::sub)
                     state = State::sub;
-                else
-                    std::cout << "ERROR: received SB when already in sub state" << std::endl;
+                else // received SB when already in sub state
+                    Record(TelnetTrace::Event::error, c);
                 break;
             case WILL:
                 state = State::wait_will;
@@ -343,10 +290,8 @@ private:
     }
 
     void RxWill(char c)
-    { 
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "will " << static_cast<int>(c) << std::endl;
-        #endif
+    {
+        Record(TelnetTrace::Event::will, c);
         switch(c)
         {
             case SUPPRESS_GO_AHEAD:
@@ -360,18 +305,12 @@ private:
         };
     }
     void RxWont(char c)
-    { 
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "wont " << static_cast<int>(c) << std::endl;
-        #else
-        (void)c;
-        #endif
+    {
+        Record(TelnetTrace::Event::wont, c);
     }
     void RxDo(char c)
-    { 
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "do " << static_cast<int>(c) << std::endl;
-        #endif
+    {
+        Record(TelnetTrace::Event::do_, c);
         switch (c)
         {
             case _ECHO:
@@ -386,19 +325,11 @@ private:
     }
     void RxDont(char c)
     {
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "dont " << static_cast<int>(c) << std::endl;
-        #else
-        (void)c;
-        #endif
+        Record(TelnetTrace::Event::dont, c);
     }
     void RxSub(char c)
-    { 
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "sub: " << static_cast<int>(c) << std::endl;
-        #else
-        (void)c;
-        #endif
+    {
+        Record(TelnetTrace::Event::sub, c);
     }
     void SendIacCmd(char action, char op)
     {
@@ -407,29 +338,25 @@ private:
         answer[2] = op;
         this -> OutStream() << answer << std::flush;
     }
+    void Record(TelnetTrace::Event event, char c)
+    {
+        if (trace) trace->Record(traceId, event, c);
+    }
 protected:
-    virtual void Output(char c)
+    virtual void OnInterrupt() {} // the client sent IAC IP
+    virtual void Output(char /*c*/) {}
+    // receives a sequence of data chars without special ones (see IsTelnetSpecial)
+    virtual void Output(const char* _data, std::size_t size)
     {
-        #ifdef CLI_TELNET_TRACE
-        std::cout << "data: " << static_cast<int>(c) << std::endl;
-        #else
-        (void)c;
-        #endif
+        for (std::size_t i = 0; i < size; ++i)
+            Output(_data[i]);
     }
 private:
     enum class State { data, sub, wait_will, wait_wont, wait_do, wait_dont };
     State state = State::data;
     bool escape = false;
-
-#endif
-
-private:
-    void Feed(char c)
-    {
-        if (std::isprint(c)) std::cout << c << std::endl;
-        else std::cout << "0x" << std::hex << static_cast<int>(c) << std::dec << std::endl;
-    }
-    std::string buffer;
+    std::shared_ptr<TelnetTrace> trace;
+    std::size_t traceId = 0;
 };
 
 template <typename ASIOLIB>
@@ -437,12 +364,15 @@ class TelnetServer : public Server<ASIOLIB>
 {
 public:
     TelnetServer(typename ASIOLIB::ContextType& ios, unsigned short port) :
-        Server<ASIOLIB>(ios, port)
+        Server<ASIOLIB>(ios, port),
+        scheduler(ios)
     {}
     std::shared_ptr<Session> CreateSession(asiolib::ip::tcp::socket _socket) override
     {
-        return std::make_shared<TelnetSession>(std::move(_socket));
+        return std::make_shared<TelnetSession>(std::move(_socket), scheduler);
     }
+private:
+    GenericAsioScheduler<ASIOLIB> scheduler;
 };
 
 //////////////
@@ -453,10 +383,11 @@ public:
 
     CliTelnetSession(Scheduler& _scheduler, asiolib::ip::tcp::socket _socket, Cli& _cli, const std::function< void(std::ostream&)>& _exitAction, std::size_t historySize ) :
         InputDevice(_scheduler),
-        TelnetSession(std::move(_socket)),
+        TelnetSession(std::move(_socket), _scheduler),
         CliSession(_cli, TelnetSession::OutStream(), historySize),
         poll(*this, *this)
     {
+        UseScheduler(_scheduler);
         ExitAction([this, _exitAction](std::ostream& _out){ _exitAction(_out), Disconnect(); } );
     }
 protected:
@@ -468,6 +399,28 @@ protected:
         Prompt();
     }
 
+    void OnInterrupt() override
+    {
+        Notify(std::make_pair(KeyType::interrupt, ' '));
+    }
+
+    void OnCommandCompleted() override
+    {
+        CliSession::OnCommandCompleted();
+        poll.Resume();
+    }
+
+    void Output(const char* _data, std::size_t size) override
+    {
+        std::size_t i = 0;
+        // first complete the pending key sequence, if any
+        for (; i < size && step != Step::_1; ++i)
+            Output(_data[i]);
+        // then there is only text
+        if (i < size)
+            Notify(_data + i, size - i);
+    }
+
     void Output(char c) override // NB: C++ does not specify wether char is signed or unsigned
     {
         switch(step)
@@ -478,12 +431,16 @@ protected:
                     case static_cast<char>(EOF):
                     case 4:  // EOT
                         Notify(std::make_pair(KeyType::eof,' ')); break;
+                    case 3: // ctrl+C
+                        Notify(std::make_pair(KeyType::interrupt, ' ')); break;
                     case 8: // Backspace
                     case 127:  // Backspace or Delete
                         Notify(std::make_pair(KeyType::backspace, ' ')); break;
                     //case 10: Notify(std::make_pair(KeyType::ret,' ')); break;
                     case 12: // ctrl+L
                         Notify(std::make_pair(KeyType::clear, ' ')); break;
+                    case 18: // ctrl+R
+                        Notify(std::make_pair(KeyType::search, ' ')); break;
                     case 27: step = Step::_2; break;  // symbol
                     case 13: step = Step::wait_0; break;  // wait for 0 (ENTER key)
                     default: // ascii
@@ -564,6 +521,17 @@ public:
         historySize(_historySize)
     {}
 
+    ~CliGenericTelnetServer() override
+    {
+        if (workers.empty()) return;
+        // the pending socket belongs to a worker context
+        this->StopAccept();
+        for (auto& w: workers)
+            w->scheduler.Stop();
+        for (auto& w: workers)
+            w->thread.join();
+    }
+
     void EnterAction(std::function< void(std::ostream&)> action)
     {
         enterAction = action;
@@ -573,16 +541,98 @@ public:
     {
         exitAction = action;
     }
+    // see Session::OutputLimits
+    void OutputLimits(std::size_t _flushThreshold, std::size_t _highWaterMark,
+                      std::chrono::milliseconds _writeTimeout = std::chrono::seconds(10),
+                      std::size_t _maxOutput = 64 * 1024 * 1024)
+    {
+        flushThreshold = _flushThreshold;
+        highWaterMark = _highWaterMark;
+        writeTimeout = _writeTimeout;
+        maxOutput = _maxOutput;
+    }
+
+    // Runs the sessions in n threads, each one with its own context.
+    // The connections are assigned to the threads in turn: the handlers of a
+    // session never run concurrently, but the ones of different sessions do,
+    // so the commands of the cli must be thread safe.
+    // Call it once, before the connections start.
+    void WorkerThreads(std::size_t n)
+    {
+        assert(workers.empty());
+        for (std::size_t i = 0; i < n; ++i)
+            workers.push_back(std::make_unique<Worker>());
+        this->RestartAccept();
+    }
+
     std::shared_ptr<Session> CreateSession(asiolib::ip::tcp::socket _socket) override
     {
-        return std::make_shared<CliTelnetSession>(scheduler, std::move(_socket), cli, exitAction, historySize);
+        auto session = std::make_shared<CliTelnetSession>(*sessionScheduler, std::move(_socket), cli, exitAction, historySize);
+        session->OutputLimits(flushThreshold, highWaterMark, writeTimeout, maxOutput);
+        session->Trace(trace);
+        return session;
     }
+
+    // Records the telnet protocol events of the sessions opened from now on,
+    // keeping the last traceCapacity ones.
+    void EnableTrace(std::size_t traceCapacity = 1024)
+    {
+        trace = std::make_shared<TelnetTrace>(traceCapacity);
+    }
+
+    // The sessions opened from now on are not traced.
+    void DisableTrace()
+    {
+        trace.reset();
+    }
+
+    // Writes the recorded protocol events on out.
+    void DumpTrace(std::ostream& out) const
+    {
+        if (trace) trace->Dump(out);
+    }
+
+protected:
+    typename ASIOLIB::ContextType& SessionContext() override
+    {
+        if (workers.empty())
+            sessionScheduler = &scheduler;
+        else
+        {
+            sessionScheduler = &workers[nextWorker]->scheduler;
+            nextWorker = (nextWorker + 1) % workers.size();
+        }
+        return sessionScheduler->AsioContext();
+    }
+
+    // the session is started in its own thread
+    void StartSession(const std::shared_ptr<Session>& session) override
+    {
+        sessionScheduler->Post([session](){ session->Start(); });
+    }
+
 private:
-    Scheduler& scheduler;
+    GenericAsioScheduler<ASIOLIB>& scheduler;
     Cli& cli;
     std::function< void(std::ostream&)> enterAction;
     std::function< void(std::ostream&)> exitAction;
     std::size_t historySize;
+    std::size_t flushThreshold = 4096;
+    std::size_t highWaterMark = 1024 * 1024;
+    std::chrono::milliseconds writeTimeout = std::chrono::seconds(10);
+    std::size_t maxOutput = 64 * 1024 * 1024;
+    std::shared_ptr<TelnetTrace> trace;
+
+    struct Worker
+    {
+        Worker() : thread([this](){ scheduler.Run(); }) {}
+        GenericAsioScheduler<ASIOLIB> scheduler;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::size_t nextWorker = 0;
+    // the scheduler of the connection being accepted
+    GenericAsioScheduler<ASIOLIB>* sessionScheduler = &scheduler;
 };
 
 
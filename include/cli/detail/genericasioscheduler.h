@@ -94,11 +94,31 @@ public:
         executor.Post(f);
     }
 
+    TimerHandle PostAt(Clock::time_point t, const std::function<void()>& f) override
+    {
+        auto state = std::make_shared<TimerHandle::State>();
+        auto timer = std::make_shared<SteadyTimer>(*context, t);
+        // the timer must be cancelled in the thread of the context
+        std::weak_ptr<SteadyTimer> weakTimer = timer;
+        ExecutorType ex = executor;
+        state->onCancel = [ex, weakTimer]() mutable
+        {
+            ex.Post([weakTimer](){ if (auto tm = weakTimer.lock()) tm->cancel(); });
+        };
+        timer->async_wait([timer, state, f](const auto& ec)
+        {
+            if (!ec && !state->cancelled)
+                f();
+        });
+        return TimerHandle(state);
+    }
+
     ContextType& AsioContext() { return *context; }
 
 private:
 
     using ExecutorType = typename ASIOLIB::Executor;
+    using SteadyTimer = typename ASIOLIB::SteadyTimer;
 
     bool owned = false;
     ContextType* context;
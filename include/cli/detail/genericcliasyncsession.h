@@ -47,6 +47,7 @@ public:
         CliSession(_cli, std::cout, 1),
         input(_scheduler.AsioContext(), ::dup(STDIN_FILENO))
     {
+        UseScheduler(_scheduler);
         Read();
     }
     ~GenericCliAsyncSession() noexcept override
@@ -54,6 +55,13 @@ public:
         try { input.close(); } catch (const std::exception&) { /* do nothing */ }
     }
 
+protected:
+
+    void OnCommandCompleted() override
+    {
+        Read(); // resume reading after an asynchronous command
+    }
+
 private:
 
     void Read()
@@ -81,7 +89,8 @@ private:
             inputBuffer.consume( length );
 
             Feed( s );
-            Read();
+            if (!Busy())
+                Read();
         }
         else
         {
@@ -30,23 +30,30 @@
 #ifndef CLI_DETAIL_HISTORY_H_
 #define CLI_DETAIL_HISTORY_H_
 
-#include <deque>
 #include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <cassert>
+#include "../historystorage.h"
+#include "ringbuffer.h"
 
 namespace cli
 {
 namespace detail
 {
 
+// The history of the commands of a session.
+// The commands loaded from a HistorySnapshot are shared with the other sessions
+// and copied in the session only when they're browsed.
+// The own commands are kept in a ring buffer, whose strings are reused
+// by the next commands once the history is full.
 class History
 {
 public:
 
-    explicit History(std::size_t size) : maxSize(size) {}
+    explicit History(std::size_t size) : maxSize(size), buffer(size) {}
 
     // Insert a new item in the buffer, changing the current state to "inserting"
     // If we're browsing the history (eg with arrow keys) the new item overwrites
@@ -58,15 +65,15 @@ public:
         current = 0;
         if (mode == Mode::browsing)
         {
-            assert(!buffer.empty());
-            if (buffer.size() > 1 && buffer[1] == item) // try to insert an element identical to last one
-                buffer.pop_front();
+            assert(!buffer.Empty());
+            if (Size() > 1 && Materialize(1) == item) // try to insert an element identical to last one
+                buffer.PopFront();
             else // the item was not identical
                 buffer[current] = item;
         }
         else // Mode::inserting
         {
-            if (buffer.empty() || buffer[0] != item) // insert an element not equal to last one
+            if (Size() == 0 || Get(0) != item) // insert an element not equal to last one
                 Insert(item);
         }
         mode = Mode::inserting;
@@ -83,40 +90,40 @@ public:
         {
             Insert(line);
             mode = Mode::browsing;
-            current = (buffer.size() > 1) ? 1 : 0;
+            current = (Size() > 1) ? 1 : 0;
         }
         else // Mode::browsing
         {
-            assert(!buffer.empty());
+            assert(!buffer.Empty());
             buffer[current] = line;
-            if (current != buffer.size()-1)
+            if (current != Size()-1)
                 ++current;
         }
         assert(mode == Mode::browsing);
-        assert(current < buffer.size());
-        return buffer[current];
+        assert(current < Size());
+        return Materialize(current);
     }
 
     // Return the next item of the history, updating the current item.
     std::string Next()
     {
-        if (buffer.empty() || current == 0)
+        if (Size() == 0 || current == 0)
             return {};
         assert(current != 0);
         --current;
-        assert(current < buffer.size());
+        assert(current < buffer.Size());
         return buffer[current];
     }
 
     // Show the whole history on the given ostream
     void Show(std::ostream& out) const
     {
-        const auto size = buffer.size();
+        const auto size = Size();
         out << '\n';
         for (std::size_t i = 0; i < size; ++i)
         {
             const auto j = size-1-i;
-            out << IndexToId(j) << '\t' << buffer[j] << '\n';
+            out << IndexToId(j) << '\t' << Get(j) << '\n';
         }
         out << '\n' << std::flush;
     }
@@ -128,67 +135,134 @@ public:
             Insert(c);
     }
 
+    // Loads the commands of the snapshot, without copying them.
+    // It must be called before any other method.
+    void LoadCommands(std::shared_ptr<const HistorySnapshot> snapshot)
+    {
+        assert(Size() == 0 && !base);
+        base = std::move(snapshot);
+        baseEnd = base->Size();
+        baseBegin = baseEnd - std::min(baseEnd, maxSize);
+        idOfOldest = baseBegin;
+    }
+
     // result[0] is the oldest command, result[size-1] the newer
     std::vector<std::string> GetCommands() const
     {
-        auto numCmdsToReturn = std::min(commands, buffer.size());
-        auto start = buffer.begin();
+        auto numCmdsToReturn = std::min(commands, Size());
+        std::size_t start = 0;
         if (mode == Mode::browsing)
         {
-            numCmdsToReturn = std::min(commands, buffer.size()-1);
-            start = buffer.begin()+1;
+            numCmdsToReturn = std::min(commands, Size()-1);
+            start = 1;
         }
-        std::vector<std::string> result(numCmdsToReturn);
-        assert(std::distance(start, buffer.end()) >= 0);
-        assert(numCmdsToReturn <= static_cast<std::size_t>(std::distance(buffer.end(), start)));
-        assert(numCmdsToReturn <= static_cast<unsigned long>(std::numeric_limits<long>::max()));
-        std::reverse_copy(start, start+static_cast<long>(numCmdsToReturn), result.begin());
+        std::vector<std::string> result;
+        result.reserve(numCmdsToReturn);
+        for (std::size_t i = numCmdsToReturn; i > 0; --i)
+            result.push_back(Get(start+i-1));
         return result;
     }
 
     std::string At(std::size_t id) const
     {
         std::size_t index = IdToIndex(id);
-        assert(index < buffer.size());
-        return buffer[index];
+        assert(index < Size());
+        return Get(index);
+    }
+
+    // Searches the newest item containing text, starting from the item
+    // with the given index (0 is the newest).
+    // If found, returns true and sets index and item.
+    bool Search(const std::string& text, std::size_t& index, std::string& item) const
+    {
+        for (std::size_t i = index; i < buffer.Size(); ++i)
+        {
+            if (buffer[i].find(text) != std::string::npos)
+            {
+                index = i;
+                item = buffer[i];
+                return true;
+            }
+        }
+        // then, the items of the base (using its index)
+        const std::size_t skip = (index > buffer.Size() ? index - buffer.Size() : 0);
+        if (skip >= baseEnd - baseBegin)
+            return false;
+        const std::size_t before = baseEnd - skip;
+        const std::size_t found = base->Find(text, before);
+        if (found >= before || found < baseBegin)
+            return false;
+        index = buffer.Size() + (baseEnd - 1 - found);
+        item = base->At(found);
+        return true;
     }
 
     void ForgetLatest()
     {
-        assert(!buffer.empty());
-        buffer.pop_front();
+        assert(!buffer.Empty());
+        buffer.PopFront();
     }
 
 private:
 
+    // the number of items (own and from the base)
+    std::size_t Size() const { return buffer.Size() + (baseEnd - baseBegin); }
+
+    // the item with the given index (0 is the newest)
+    std::string Get(std::size_t index) const
+    {
+        assert(index < Size());
+        if (index < buffer.Size())
+            return buffer[index];
+        return base->At(baseEnd - 1 - (index - buffer.Size()));
+    }
+
+    // copies in buffer the items of the base up to index, so that they can be modified
+    const std::string& Materialize(std::size_t index)
+    {
+        assert(index < Size());
+        while (buffer.Size() <= index)
+        {
+            buffer.PushBack(base->At(baseEnd - 1));
+            --baseEnd;
+        }
+        return buffer[index];
+    }
+
     // oldest has index = size-1 and id = idOfOldest
     // newest has index = 0      and id = idOfOldest + size-1 
     std::size_t IndexToId(std::size_t index) const
     {
-        if (index > idOfOldest+buffer.size()-1)
+        if (index > idOfOldest+Size()-1)
             throw std::out_of_range("Index not found in history");
-        return idOfOldest + buffer.size() - 1 - index;
+        return idOfOldest + Size() - 1 - index;
     }
 
     std::size_t IdToIndex(std::size_t id) const
     {
-        if (id < idOfOldest || id > idOfOldest+buffer.size()-1)
+        if (id < idOfOldest || id > idOfOldest+Size()-1)
             throw std::out_of_range("Index not found in history");
-        return idOfOldest + buffer.size() - 1 - id;
+        return idOfOldest + Size() - 1 - id;
     }
 
     void Insert(const std::string& item)
     {
-        buffer.emplace_front(item);
-        if (buffer.size() > maxSize)
+        if (Size() == maxSize)
         {
-            buffer.pop_back();
+            if (baseBegin != baseEnd)
+                ++baseBegin; // drops the oldest of the base
             ++idOfOldest;
         }
+        buffer.PushFront(item); // when full, drops the oldest of the buffer
     }
 
     const std::size_t maxSize;
-    std::deque<std::string> buffer; // buffer[0] is the newest element
+    RingBuffer<std::string> buffer; // buffer[0] is the newest element
+    // The oldest elements, after the ones in buffer, are the elements
+    // of base in [baseBegin, baseEnd) (the newest of them comes first).
+    std::shared_ptr<const HistorySnapshot> base;
+    std::size_t baseBegin = 0;
+    std::size_t baseEnd = 0;
     std::size_t current = 0;
     std::size_t commands = 0; // number of commands issued
     enum class Mode { inserting, browsing };
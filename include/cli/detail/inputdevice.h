@@ -30,8 +30,10 @@
 #ifndef CLI_DETAIL_INPUTDEVICE_H_
 #define CLI_DETAIL_INPUTDEVICE_H_
 
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <utility>
 #include "../scheduler.h"
 
 namespace cli
@@ -39,12 +41,13 @@ namespace cli
 namespace detail
 {
 
-enum class KeyType { ascii, up, down, left, right, backspace, canc, home, end, ret, eof, ignored, clear, };
+enum class KeyType { ascii, up, down, left, right, backspace, canc, home, end, ret, eof, ignored, clear, search, interrupt, };
 
 class InputDevice
 {
 public:
     using Handler = std::function< void( std::pair<KeyType,char> ) >;
+    using TextHandler = std::function< void( const char* text, std::size_t size ) >;
 
     explicit InputDevice(Scheduler& _scheduler) : scheduler(_scheduler) {}
     virtual ~InputDevice() = default;
@@ -54,6 +57,15 @@ public:
     template <typename H>
     void Register(H&& h) { handler = std::forward<H>(h); }
 
+    // t receives the text runs at once,
+    // otherwise they're passed to h as a sequence of ascii keys
+    template <typename H, typename T>
+    void Register(H&& h, T&& t)
+    {
+        handler = std::forward<H>(h);
+        textHandler = std::forward<T>(t);
+    }
+
 protected:
 
     void Notify(std::pair<KeyType,char> k)
@@ -61,10 +73,26 @@ protected:
         scheduler.Post([this,k](){ if (handler) handler(k); });
     }
 
+    // Notifies a run of text typed at once (e.g., pasted).
+    // The text must contain only printable chars, i.e. chars that would be
+    // notified one by one as KeyType::ascii (so, no tabs)
+    void Notify(const char* text, std::size_t size)
+    {
+        scheduler.Post([this, s = std::string(text, size)]()
+        {
+            if (textHandler)
+                textHandler(s.data(), s.size());
+            else if (handler)
+                for (char c: s)
+                    handler(std::make_pair(KeyType::ascii, c));
+        });
+    }
+
 private:
 
     Scheduler& scheduler;
     Handler handler;
+    TextHandler textHandler;
 };
 
 } // namespace detail
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_KEYDECODER_H_
+#define CLI_DETAIL_KEYDECODER_H_
+
+#include <cstdio> // EOF
+#include <utility>
+#include "inputdevice.h"
+
+namespace cli
+{
+namespace detail
+{
+
+// Translates the bytes read from a terminal in raw mode into keys.
+// The bytes are fed one at a time, so that an escape sequence can be split
+// among different reads.
+class KeyDecoder
+{
+public:
+
+    // returns true if c completes a key (stored in key)
+    bool Feed(char c, std::pair<KeyType,char>& key)
+    {
+        switch (state)
+        {
+            case State::data:
+                return Data(c, key);
+            case State::escape: // ESC
+                if (c == 91) // '[': arrow keys
+                {
+                    state = State::bracket;
+                    return false;
+                }
+                return Emit(KeyType::ignored, key);
+            case State::bracket: // ESC [
+                switch (c)
+                {
+                    case 51:
+                        state = State::tilde;
+                        return false;
+                    case 65: return Emit(KeyType::up, key);
+                    case 66: return Emit(KeyType::down, key);
+                    case 68: return Emit(KeyType::left, key);
+                    case 67: return Emit(KeyType::right, key);
+                    case 70: return Emit(KeyType::end, key);
+                    case 72: return Emit(KeyType::home, key);
+                    default: return Emit(KeyType::ignored, key);
+                }
+            case State::tilde: // ESC [ 3
+                return Emit(c == 126 ? KeyType::canc : KeyType::ignored, key);
+        }
+        return false; // cannot reach this point
+    }
+
+    // true if no escape sequence is in progress,
+    // so that the next printable chars will be decoded as ascii keys
+    bool Idle() const { return state == State::data; }
+
+private:
+
+    enum class State { data, escape, bracket, tilde };
+
+    bool Data(char c, std::pair<KeyType,char>& key)
+    {
+        switch (c)
+        {
+            case EOF:
+            case 4:  // EOT
+                key = std::make_pair(KeyType::eof, ' ');
+                return true;
+            case 3: // ctrl+C
+                key = std::make_pair(KeyType::interrupt, ' ');
+                return true;
+            case 127:
+            case 8:
+                key = std::make_pair(KeyType::backspace, ' ');
+                return true;
+            case 10:
+                key = std::make_pair(KeyType::ret, ' ');
+                return true;
+            case 12:
+                key = std::make_pair(KeyType::clear, ' ');
+                return true;
+            case 18: // ctrl+R
+                key = std::make_pair(KeyType::search, ' ');
+                return true;
+            case 27: // symbol
+                state = State::escape;
+                return false;
+            default: // ascii
+                key = std::make_pair(KeyType::ascii, c);
+                return true;
+        }
+    }
+
+    bool Emit(KeyType type, std::pair<KeyType,char>& key)
+    {
+        state = State::data;
+        key = std::make_pair(type, ' ');
+        return true;
+    }
+
+    State state = State::data;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_KEYDECODER_H_
@@ -34,6 +34,7 @@
 #include <memory>
 #include <stdexcept>
 
+#include <cerrno>
 #include <cstdio>
 #include <termios.h>
 #include <unistd.h>
@@ -41,6 +42,8 @@
 #include <cassert>
 #include <condition_variable>
 #include "inputdevice.h"
+#include "keydecoder.h"
+#include "telnetscanner.h"
 
 
 namespace cli
@@ -149,8 +152,30 @@ public:
                     std::unique_lock<std::mutex> lock(mtx);
                     cv.wait(lock, [this]{ return enabled; }); // release mtx, suspend thread execution until enabled becomes true
                 }
-                auto k = Get();
-                Notify(k);
+                if (bufferBegin == bufferEnd)
+                {
+                    if (!Fill())
+                    {
+                        Notify(std::make_pair(KeyType::eof, ' '));
+                        return;
+                    }
+                    continue;
+                }
+                // the printable chars read at once (e.g., pasted) are notified as a whole
+                // (the special chars of a terminal are the same of telnet)
+                const char* first = buffer + bufferBegin;
+                const char* runEnd = decoder.Idle() ? FindTelnetSpecial(first, buffer + bufferEnd) : first;
+                if (runEnd != first)
+                {
+                    Notify(first, static_cast<std::size_t>(runEnd - first));
+                    bufferBegin += static_cast<std::size_t>(runEnd - first);
+                }
+                else
+                {
+                    std::pair<KeyType,char> key;
+                    if (decoder.Feed(buffer[bufferBegin++], key))
+                        Notify(key);
+                }
             }
         }
         catch(const std::exception&)
@@ -159,59 +184,15 @@ public:
         }
     }
 
-    char GetChar()
-    {
-        char buffer = 0;
-        auto unused = read(0, &buffer, 1);
-        static_cast<void>(unused); // silence unused warn
-        return buffer;
-    }
-
-    std::pair<KeyType,char> Get()
+    // waits for input and reads all the chars available
+    // (returns false when the input is closed)
+    bool Fill()
     {
         is.WaitKbHit();
-
-        auto ch = GetChar();
-        switch(ch)
-        {
-            case EOF:
-            case 4:  // EOT
-                return std::make_pair(KeyType::eof,' ');
-                break;
-            case 127:
-            case 8:
-                return std::make_pair(KeyType::backspace,' '); break;
-            case 10: return std::make_pair(KeyType::ret,' '); break;
-            case 12: return std::make_pair(KeyType::clear, ' '); break;
-            case 27: // symbol
-                ch = GetChar();
-                if ( ch == 91 ) // arrow keys
-                {
-                    ch = GetChar();
-                    switch( ch )
-                    {
-                        case 51:
-                            ch = GetChar();
-                            if ( ch == 126 ) return std::make_pair(KeyType::canc,' ');
-                            else return std::make_pair(KeyType::ignored,' ');
-                            break;
-                        case 65: return std::make_pair(KeyType::up,' ');
-                        case 66: return std::make_pair(KeyType::down,' ');
-                        case 68: return std::make_pair(KeyType::left,' ');
-                        case 67: return std::make_pair(KeyType::right,' ');
-                        case 70: return std::make_pair(KeyType::end,' ');
-                        case 72: return std::make_pair(KeyType::home,' ');
-                        default: return std::make_pair(KeyType::ignored,' ');
-                    }
-                }
-                break;
-            default: // ascii
-            {
-                const char c = static_cast<char>(ch);
-                return std::make_pair(KeyType::ascii,c);
-            }
-        }
-        return std::make_pair(KeyType::ignored,' ');
+        const auto n = read(0, buffer, sizeof(buffer));
+        bufferBegin = 0;
+        bufferEnd = (n > 0 ? static_cast<std::size_t>(n) : 0);
+        return n > 0 || (n < 0 && errno == EINTR);
     }
 
     void ToManualMode()
@@ -219,20 +200,33 @@ public:
         constexpr tcflag_t ICANON_FLAG = ICANON;
         constexpr tcflag_t ECHO_FLAG = ECHO;
 
+        if (manualMode) return; // otherwise, oldt would lose the standard settings
         tcgetattr(STDIN_FILENO, &oldt);
         newt = oldt;
         newt.c_lflag &= ~( ICANON_FLAG | ECHO_FLAG );
+        // ctrl+C is read as a key, instead of raising SIGINT, only while the input is active
+        // (i.e., the session is idle or runs an asynchronous command):
+        // the standard mode raises SIGINT again while a synchronous handler runs
+        newt.c_cc[VINTR] = _POSIX_VDISABLE;
         tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+        manualMode = true;
     }
 
     void ToStandardMode()
     {
+        if (!manualMode) return;
         tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+        manualMode = false;
     }
 
     bool enabled;
+    KeyDecoder decoder;
+    char buffer[256]; // input read and not yet processed
+    std::size_t bufferBegin = 0;
+    std::size_t bufferEnd = 0;
     termios oldt;
     termios newt;
+    bool manualMode = false;
     InputSource is;
     std::mutex mtx;
     std::condition_variable cv;
@@ -47,6 +47,7 @@ public:
 
     using ContextType = boost::asio::io_context;
     using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+    using SteadyTimer = boost::asio::steady_timer;
 
     class Executor
     {
@@ -82,6 +83,13 @@ public:
 
 };
 
+// calls handler(ec) when the socket can be written without blocking
+template <typename Handler>
+void AsyncWaitWritable(boost::asio::ip::tcp::socket& socket, Handler&& handler)
+{
+    socket.async_wait(boost::asio::socket_base::wait_write, std::forward<Handler>(handler));
+}
+
 } // namespace detail
 } // namespace cli
 
@@ -47,6 +47,7 @@ public:
 
     using ContextType = asio::io_context;
     using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
+    using SteadyTimer = asio::steady_timer;
 
     class Executor
     {
@@ -82,6 +83,13 @@ public:
 
 };
 
+// calls handler(ec) when the socket can be written without blocking
+template <typename Handler>
+void AsyncWaitWritable(asio::ip::tcp::socket& socket, Handler&& handler)
+{
+    socket.async_wait(asio::socket_base::wait_write, std::forward<Handler>(handler));
+}
+
 } // namespace detail
 } // namespace cli
 
@@ -45,6 +45,7 @@ class OldBoostAsioLib
 public:
     using ContextType = boost::asio::io_service;
     using WorkGuard = boost::asio::io_service::work;
+    using SteadyTimer = boost::asio::steady_timer;
 
     class Executor
     {
@@ -75,6 +76,14 @@ public:
 
 };
 
+// calls handler(ec) when the socket can be written without blocking
+template <typename Handler>
+void AsyncWaitWritable(boost::asio::ip::tcp::socket& socket, Handler handler)
+{
+    socket.async_write_some(boost::asio::null_buffers(),
+        [handler](boost::system::error_code ec, std::size_t /*length*/) mutable { handler(ec); });
+}
+
 } // namespace detail
 } // namespace cli
 
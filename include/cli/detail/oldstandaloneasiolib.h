@@ -48,6 +48,7 @@ public:
 
     using ContextType = asio::io_service;
     using WorkGuard = asio::io_service::work;
+    using SteadyTimer = asio::steady_timer;
 
     class Executor
     {
@@ -78,6 +79,14 @@ public:
 
 };
 
+// calls handler(ec) when the socket can be written without blocking
+template <typename Handler>
+void AsyncWaitWritable(asio::ip::tcp::socket& socket, Handler handler)
+{
+    socket.async_write_some(asio::null_buffers(),
+        [handler](asio::error_code ec, std::size_t /*length*/) mutable { handler(ec); });
+}
+
 } // namespace detail
 } // namespace cli
 
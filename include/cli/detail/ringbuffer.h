@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_RINGBUFFER_H_
+#define CLI_DETAIL_RINGBUFFER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace cli
+{
+namespace detail
+{
+
+// A double-ended queue with a fixed capacity.
+// When it's full, a push on one end drops the item on the other end.
+// The slots are allocated on demand up to the capacity and then reused:
+// the items popped or dropped are assigned and not destroyed, so that
+// (e.g.) the strings keep their memory for the next items.
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(std::size_t _capacity) : capacity(_capacity) {}
+
+    std::size_t Size() const { return count; }
+    bool Empty() const { return count == 0; }
+    bool Full() const { return count == capacity; }
+    std::size_t Capacity() const { return capacity; }
+
+    // item[0] is the front
+    T& operator[](std::size_t i) { assert(i < count); return slots[Slot(i)]; }
+    const T& operator[](std::size_t i) const { assert(i < count); return slots[Slot(i)]; }
+
+    void PushFront(const T& item)
+    {
+        if (capacity == 0)
+            return;
+        if (!Full())
+        {
+            Reserve();
+            ++count;
+        }
+        // when full, the back slot becomes the front
+        head = (head + slots.size() - 1) % slots.size();
+        slots[head] = item;
+    }
+
+    void PushBack(const T& item)
+    {
+        if (capacity == 0)
+            return;
+        if (Full())
+        {
+            // the front slot becomes the back
+            slots[head] = item;
+            head = (head + 1) % slots.size();
+            return;
+        }
+        Reserve();
+        slots[Slot(count)] = item;
+        ++count;
+    }
+
+    void PopFront()
+    {
+        assert(count > 0);
+        head = (head + 1) % slots.size();
+        --count;
+    }
+
+    void PopBack()
+    {
+        assert(count > 0);
+        --count;
+    }
+
+    void Clear() { count = 0; }
+
+private:
+
+    std::size_t Slot(std::size_t i) const { return (head + i) % slots.size(); }
+
+    // makes sure there is a free slot, growing the storage when all the
+    // slots are in use. The items are rotated so that the new slot is both
+    // after the back and before the front.
+    void Reserve()
+    {
+        assert(count < capacity);
+        if (count < slots.size())
+            return;
+        std::rotate(slots.begin(), slots.begin() + static_cast<typename std::vector<T>::difference_type>(head), slots.end());
+        head = 0;
+        slots.emplace_back();
+    }
+
+    const std::size_t capacity;
+    std::vector<T> slots;
+    std::size_t head = 0; // the slot of the front item
+    std::size_t count = 0;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_RINGBUFFER_H_
@@ -30,8 +30,14 @@
 #ifndef CLI_DETAIL_SERVER_H_
 #define CLI_DETAIL_SERVER_H_
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <string>
+#include <thread>
+#include "../scheduler.h"
 
 namespace cli
 {
@@ -44,18 +50,54 @@ public:
     ~Session() override = default;
     virtual void Start()
     {
+        owner = std::this_thread::get_id();
+        {
+            std::lock_guard<std::mutex> lock(outMtx);
+            weakSelf = shared_from_this();
+        }
+        PostFlush(); // the output written by other threads before starting
         OnConnect();
         Read();
     }
 
+    // The output is gathered in a buffer and written asynchronously to the socket
+    // at the end of the handler that produced it (also when the stream is flushed),
+    // or when the buffer reaches flushThreshold bytes.
+    // While the output not yet written exceeds highWaterMark bytes, the session
+    // stops reading its input (so, no new command starts), and the client is
+    // dropped if the output doesn't go back below highWaterMark within writeTimeout.
+    // The client is dropped also when the output not yet written exceeds maxOutput bytes
+    // (e.g., because a single command writes too much).
+    // The output stream can be written by other threads (e.g., by Cli::cout):
+    // the socket is only written by the thread running the session.
+    void OutputLimits(std::size_t _flushThreshold, std::size_t _highWaterMark,
+                      std::chrono::milliseconds _writeTimeout = std::chrono::seconds(10),
+                      std::size_t _maxOutput = 64 * 1024 * 1024)
+    {
+        flushThreshold = _flushThreshold;
+        highWaterMark = _highWaterMark;
+        writeTimeout = _writeTimeout;
+        maxOutput = _maxOutput;
+    }
+
 protected:
 
-    explicit Session(asiolib::ip::tcp::socket _socket) : socket(std::move(_socket)), outStream( this ) {}
+    // scheduler must post on the context of the socket
+    Session(asiolib::ip::tcp::socket _socket, Scheduler& _scheduler) :
+        socket(std::move(_socket)), scheduler(_scheduler), outStream( this )
+    {
+        // the output is already gathered: don't delay the writes waiting for the acks
+        asiolibec::error_code ec;
+        socket.set_option(asiolib::ip::tcp::no_delay(true), ec);
+        // the output is written as long as the socket accepts it, then we wait
+        socket.non_blocking(true, ec);
+    }
 
+    // closes the connection after writing the pending output
     virtual void Disconnect()
     {
-        socket.shutdown(asiolib::ip::tcp::socket::shutdown_both);
-        socket.close();
+        disconnecting = true;
+        Flush();
     }
 
     virtual void Read()
@@ -71,19 +113,18 @@ protected:
               else
               {
                   OnDataReceived( std::string( data, length ));
-                  Read();
+                  if (throttled)
+                      readPaused = true; // Throttle reads again
+                  else
+                      Read();
               }
           });
     }
 
     virtual void Send(const std::string& msg)
     {
-        asiolibec::error_code ec;
-        asiolib::write(socket, asiolib::buffer(msg), ec);
-        if ((ec == asiolib::error::eof) || (ec == asiolib::error::connection_reset))
-            OnDisconnect();
-        else if (ec)
-            OnError();
+        Append(msg.data(), msg.size());
+        Flush();
     }
 
     virtual std::ostream& OutStream() { return outStream; }
@@ -93,25 +134,233 @@ protected:
     virtual void OnError() = 0;
     virtual void OnDataReceived(const std::string& _data) = 0;
 
-    virtual std::string Encode(const std::string& _data) const { return _data; }
+    // appends to out the encoding of [_data, _data+size)
+    virtual void Encode(const char* _data, std::size_t size, std::string& out) const { out.append(_data, size); }
 
 private:
 
     // std::streambuf
     std::streamsize xsputn( const char* s, std::streamsize n ) override
     {
-        Send(Encode(std::string(s, s+n)));
+        Append(s, static_cast<std::size_t>(n));
         return n;
     }
     int overflow( int c ) override
     {
-        Send(Encode(std::string(1, static_cast< char >(c))));
+        if (c != traits_type::eof())
+        {
+            const char ch = static_cast< char >(c);
+            Append(&ch, 1);
+        }
         return c;
     }
+    int sync() override
+    {
+        // the flushes of a handler (e.g., std::endl) end up in a single write
+        PostFlush();
+        return 0;
+    }
+
+    bool OwnerThread() const { return std::this_thread::get_id() == owner; }
+
+    // the output not yet written (outMtx must be locked)
+    std::size_t Pending() const { return outBuffer.size() + writeBuffer.size() - writeOffset; }
+
+    // can be called by any thread
+    void Append(const char* s, std::size_t n)
+    {
+        std::unique_lock<std::mutex> lock(outMtx);
+        if (closed) return;
+        Encode(s, n, outBuffer);
+        if (Pending() > maxOutput)
+        {
+            // the client doesn't keep up with the output
+            outBuffer.clear();
+            closed = true;
+            auto self( weakSelf.lock() );
+            lock.unlock();
+            if (self)
+                scheduler.Post([this, self](){ Close(); });
+            return;
+        }
+        const bool flushNow = outBuffer.size() >= flushThreshold && OwnerThread();
+        lock.unlock();
+        if (flushNow)
+            Flush();
+        else
+            PostFlush();
+    }
+
+    // flushes at the end of the current handler, in the thread running the session
+    void PostFlush()
+    {
+        std::shared_ptr<Session> self;
+        {
+            std::lock_guard<std::mutex> lock(outMtx);
+            if (flushPosted) return;
+            // not started yet (Start flushes) or being destroyed
+            self = weakSelf.lock();
+            if (!self) return;
+            flushPosted = true;
+        }
+        scheduler.Post([this, self]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(outMtx);
+                flushPosted = false;
+            }
+            Flush();
+        });
+    }
+
+    enum class WriteResult { done, wouldBlock, failed };
+
+    // writes the buffered output until the socket accepts it
+    WriteResult WriteSome()
+    {
+        std::lock_guard<std::mutex> lock(outMtx);
+        if (!socket.is_open())
+        {
+            outBuffer.clear();
+            return WriteResult::done;
+        }
+        while (true)
+        {
+            if (writeOffset == writeBuffer.size())
+            {
+                writeBuffer.clear();
+                writeOffset = 0;
+                writeBuffer.swap(outBuffer);
+                if (writeBuffer.empty())
+                    return WriteResult::done;
+            }
+            const auto n = socket.write_some(asiolib::buffer(writeBuffer.data() + writeOffset, writeBuffer.size() - writeOffset), writeError);
+            if (writeError == asiolib::error::would_block || writeError == asiolib::error::try_again)
+                return WriteResult::wouldBlock;
+            if (writeError)
+                return WriteResult::failed;
+            writeOffset += n;
+        }
+    }
+
+    void OnWriteError()
+    {
+        if ( ( writeError == asiolib::error::eof ) || ( writeError == asiolib::error::connection_reset ) )
+            OnDisconnect();
+        else
+            OnError();
+    }
+
+    // writes the buffered output, unless we're already waiting for the socket
+    // (in that case the output is written when it becomes writable)
+    void Flush()
+    {
+        if (waiting)
+        {
+            Throttle();
+            return;
+        }
+        switch (WriteSome())
+        {
+            case WriteResult::done:
+                if (disconnecting)
+                    Close();
+                break;
+            case WriteResult::wouldBlock:
+            {
+                waiting = true;
+                auto self( shared_from_this() );
+                AsyncWaitWritable(socket, [ this, self ]( asiolibec::error_code ec )
+                    {
+                        waiting = false;
+                        if ( !socket.is_open() )
+                            return;
+                        if ( ( ec == asiolib::error::eof ) || ( ec == asiolib::error::connection_reset ) )
+                            OnDisconnect();
+                        else if ( ec )
+                            OnError();
+                        else
+                            Flush();
+                    });
+                break;
+            }
+            case WriteResult::failed:
+                OnWriteError();
+                return;
+        }
+        Throttle();
+    }
+
+    // Stops reading the input while the output not yet written exceeds highWaterMark,
+    // dropping the client if it lasts more than writeTimeout.
+    void Throttle()
+    {
+        bool above = false;
+        {
+            std::lock_guard<std::mutex> lock(outMtx);
+            above = Pending() > highWaterMark;
+        }
+        if (above && !throttled && socket.is_open())
+        {
+            throttled = true;
+            auto self( shared_from_this() );
+            writeTimer = scheduler.PostAfter(writeTimeout, [this, self]()
+            {
+                if (throttled)
+                    Close();
+            });
+        }
+        else if (!above && throttled)
+        {
+            throttled = false;
+            writeTimer.Cancel();
+            if (readPaused && socket.is_open())
+            {
+                readPaused = false;
+                Read();
+            }
+        }
+    }
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(outMtx);
+            closed = true;
+            outBuffer.clear();
+        }
+        if (throttled)
+        {
+            throttled = false;
+            writeTimer.Cancel();
+        }
+        asiolibec::error_code ec;
+        socket.shutdown(asiolib::ip::tcp::socket::shutdown_both, ec);
+        socket.close(ec);
+    }
 
     asiolib::ip::tcp::socket socket;
+    Scheduler& scheduler;
     enum { max_length = 1024 };
     char data[ max_length ];
+    std::atomic<std::thread::id> owner{}; // the thread running the session handlers
+    std::mutex outMtx; // guards weakSelf, outBuffer, writeBuffer, writeOffset, flushPosted and closed
+    std::weak_ptr<Session> weakSelf; // the other threads can't call shared_from_this
+    std::string outBuffer; // output not yet written
+    std::string writeBuffer; // output being written
+    std::size_t writeOffset = 0; // the part of writeBuffer already written
+    asiolibec::error_code writeError;
+    bool waiting = false; // for the socket to become writable
+    bool flushPosted = false;
+    bool closed = false; // no more output accepted
+    bool disconnecting = false;
+    std::size_t flushThreshold = 4096;
+    std::size_t highWaterMark = 1024 * 1024;
+    std::chrono::milliseconds writeTimeout = std::chrono::seconds(10);
+    std::size_t maxOutput = 64 * 1024 * 1024;
+    bool throttled = false; // the output exceeds highWaterMark
+    bool readPaused = false; // the input is not read because of throttled
+    TimerHandle writeTimer; // drops the client when throttled for writeTimeout
     std::ostream outStream;
 };
 
@@ -124,29 +373,57 @@ public:
     Server( const Server& ) = delete;
     Server& operator = ( const Server& ) = delete;
 
-    Server(typename ASIOLIB::ContextType& ios, unsigned short port) :
+    Server(typename ASIOLIB::ContextType& _ios, unsigned short port) :
+        ios(_ios),
         acceptor(ios, asiolib::ip::tcp::endpoint(asiolib::ip::tcp::v4(), port))
     {
         Accept();
     }
-    Server(typename ASIOLIB::ContextType& ios, std::string address, unsigned short port) :
+    Server(typename ASIOLIB::ContextType& _ios, std::string address, unsigned short port) :
+        ios(_ios),
         acceptor(ios, asiolib::ip::tcp::endpoint(ASIOLIB::IpAddressFromString(address), port))
     {
         Accept();
     }
     virtual ~Server() = default;
+    // the port accepting the connections (e.g., the one chosen when port is 0)
+    unsigned short Port() const { return acceptor.local_endpoint().port(); }
     // returns shared_ptr instead of unique_ptr because Session needs to use enable_shared_from_this
     virtual std::shared_ptr<Session> CreateSession(asiolib::ip::tcp::socket socket) = 0;
+protected:
+    // returns the context of the socket of the next connection
+    // (by default the one accepting the connections)
+    virtual typename ASIOLIB::ContextType& SessionContext() { return ios; }
+    // starts a session just created
+    virtual void StartSession(const std::shared_ptr<Session>& session) { session->Start(); }
+    // cancels the pending accept, so that the next one gets a new SessionContext()
+    void RestartAccept()
+    {
+        asiolibec::error_code ec;
+        acceptor.cancel(ec);
+    }
+    // stops accepting connections
+    // (a derived class owning the session contexts must call it before destroying them)
+    void StopAccept()
+    {
+        asiolibec::error_code ec;
+        acceptor.close(ec);
+        pendingSocket.reset();
+    }
 private:
     void Accept()
     {
-        acceptor.async_accept([this](asiolibec::error_code ec, asiolib::ip::tcp::socket socket)
+        pendingSocket = std::make_unique<asiolib::ip::tcp::socket>(SessionContext());
+        acceptor.async_accept(*pendingSocket, [this](asiolibec::error_code ec)
             {
-                if (!ec) CreateSession(std::move(socket))->Start();
+                if (!acceptor.is_open()) return;
+                if (!ec) StartSession(CreateSession(std::move(*pendingSocket)));
                 Accept();
             });
     }
+    typename ASIOLIB::ContextType& ios;
     asiolib::ip::tcp::acceptor acceptor;
+    std::unique_ptr<asiolib::ip::tcp::socket> pendingSocket; // the socket of the next connection
 };
 
 
@@ -31,6 +31,7 @@
 #define CLI_DETAIL_SPLIT_H_
 
 #include <algorithm>
+#include <cstddef>
 #include <string>
 #include <utility>
 #include <vector>
@@ -44,24 +45,52 @@ namespace detail
 class Text
 {
 public:
-    explicit Text(std::string _input) : input(std::move(_input))
+    explicit Text(const std::string& _input) : input(_input)
     {
     }
-    void SplitInto(std::vector<std::string>& strs)
+    // The strings already contained in strs are reused to store the tokens,
+    // so splitting many lines into the same vector does not allocate
+    // once its strings have grown enough.
+    // Returns the number of tokens, stored in the first strings of strs:
+    // the vector doesn't shrink, so that the strings after them keep their buffers.
+    std::size_t SplitInto(std::vector<std::string>& strs)
     {
-        Reset();
-        for (char c: input)
-            Eval(c);
-        RemoveEmptyEntries();
-        splitResult.swap(strs); // puts the result back in strs
+        Reset(strs);
+        auto i = input.begin();
+        const auto end = input.end();
+        while (i != end)
+        {
+            if (state == State::word || state == State::sentence)
+            {
+                // copy the whole run of ordinary characters at once
+                const auto runEnd = std::find_if(i, end, [this](char c){ return IsSpecial(c); });
+                if (runEnd != i)
+                {
+                    Current().append(i, runEnd);
+                    i = runEnd;
+                    continue;
+                }
+            }
+            Eval(*i);
+            ++i;
+        }
+        return RemoveEmptyEntries();
     }
 private:
-    void Reset()
+    void Reset(std::vector<std::string>& strs)
     {
         state = State::space;
         prev_state = State::space;
         sentence_type = SentenceType::double_quote;
-        splitResult.clear();
+        splitResult = &strs;
+        size = 0;
+    }
+
+    bool IsSpecial(char c) const
+    {
+        if (c == '"' || c == '\'' || c == '\\')
+            return true;
+        return state == State::word && (c == ' ' || c == '\t' || c == '\n' || c == '!');
     }
 
     void Eval(char c)
@@ -99,16 +128,18 @@ private:
             // Should come back into the word state after this.
             prev_state = State::word;
             state = State::escape;
-            splitResult.emplace_back("");
+            NewToken();
         }
         else if (c == '!')
         {
-            splitResult.emplace_back(1, c);
+            NewToken();
+            Current() += c;
         }
         else
         {
             state = State::word;
-            splitResult.emplace_back(1, c);
+            NewToken();
+            Current() += c;
         }
     }
 
@@ -120,7 +151,8 @@ private:
         }
         else if (c == '!')
         {
-            splitResult.emplace_back(1, c);
+            NewToken();
+            Current() += c;
             state = State::space;
         }
         else if (c == '"' || c == '\'')
@@ -134,8 +166,7 @@ private:
         }      
         else
         {
-            assert(!splitResult.empty());
-            splitResult.back() += c;
+            Current() += c;
         }
     }
 
@@ -147,10 +178,7 @@ private:
             if (new_type == sentence_type)
                 state = State::space;
             else
-            {
-                assert(!splitResult.empty());
-                splitResult.back() += c;
-            }
+                Current() += c;
         }
         else if (c == '\\')
         {
@@ -159,17 +187,15 @@ private:
         }
         else
         {
-            assert(!splitResult.empty());
-            splitResult.back() += c;
+            Current() += c;
         }
     }
 
     void EvalEscape(char c)
     {
-        assert(!splitResult.empty());
         if (c != '"' && c != '\'' && c != '\\')
-            splitResult.back() += "\\";
-        splitResult.back() += c;
+            Current() += '\\';
+        Current() += c;
         state = prev_state;
     }
 
@@ -177,20 +203,39 @@ private:
     {
         state = State::sentence;
         sentence_type = ( c == '"' ? SentenceType::double_quote : SentenceType::quote);
-        splitResult.emplace_back("");
+        NewToken();
+    }
+
+    // appends an empty token, reusing a string of the vector if available
+    void NewToken()
+    {
+        if (size < splitResult->size())
+            (*splitResult)[size].clear();
+        else
+            splitResult->emplace_back();
+        ++size;
     }
 
-    void RemoveEmptyEntries()
+    std::string& Current()
     {
-        // remove null entries from the vector:
-        splitResult.erase(
-            std::remove_if(
-                splitResult.begin(),
-                splitResult.end(),
-                [](const std::string& s){ return s.empty(); }
-            ),
-            splitResult.end()
-        );
+        assert(size > 0);
+        return (*splitResult)[size-1];
+    }
+
+    std::size_t RemoveEmptyEntries()
+    {
+        // move the non empty tokens at the beginning of the vector
+        // (swapping to keep the buffers):
+        std::size_t nonEmpty = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if ((*splitResult)[i].empty())
+                continue;
+            if (i != nonEmpty)
+                (*splitResult)[nonEmpty].swap((*splitResult)[i]);
+            ++nonEmpty;
+        }
+        return nonEmpty;
     }
 
     enum class State { space, word, sentence, escape };
@@ -198,8 +243,9 @@ private:
     State state = State::space;
     State prev_state = State::space;
     SentenceType sentence_type = SentenceType::double_quote;
-    const std::string input;
-    std::vector<std::string> splitResult;
+    const std::string& input;
+    std::vector<std::string>* splitResult = nullptr;
+    std::size_t size = 0; // number of tokens in splitResult
 };
 
 // Split the string input into a vector of strings.
@@ -239,7 +285,16 @@ private:
 inline void split(std::vector<std::string>& strs, const std::string& input)
 {
     Text sentence(input);
-    sentence.SplitInto(strs);
+    strs.resize(sentence.SplitInto(strs));
+}
+
+// Like split, but the tokens are stored in the first strings of buffers
+// and their number is returned: the other strings are not destroyed,
+// so that splitting the following lines reuses their memory.
+inline std::size_t SplitInto(std::vector<std::string>& buffers, const std::string& input)
+{
+    Text sentence(input);
+    return sentence.SplitInto(buffers);
 }
 
 } // namespace detail
@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_STATSREGISTRY_H_
+#define CLI_DETAIL_STATSREGISTRY_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../commandstats.h"
+
+namespace cli
+{
+namespace detail
+{
+
+// The statistics recorded by one session.
+// The handlers of a session never run concurrently, so there is only one
+// writer and the counters are updated without locks or atomic increments.
+// The counters are atomic only so that they can be read while the session
+// is running. The mutex is taken by the writer only the first time it
+// records a command.
+class StatsShard
+{
+public:
+    // Records an execution of command (called by the session)
+    void Record(const std::string& command, std::uint64_t us, bool error)
+    {
+        auto i = commands.find(command);
+        if (i == commands.end())
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            i = commands.emplace(command, std::make_unique<Counters>()).first;
+        }
+        auto& c = *i->second;
+        Increment(c.count);
+        if (error) Increment(c.errors);
+        Increment(c.latency[LatencyHistogram::Bucket(us)]);
+        if (us > c.max.load(std::memory_order_relaxed))
+            c.max.store(us, std::memory_order_relaxed);
+    }
+
+    // Records a line not matching any command (called by the session)
+    void WrongCommand() { Increment(wrongCommands); }
+
+    // Adds the statistics recorded until now to stats (called by any thread)
+    void CollectInto(CliStats& stats) const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto& cmd: commands)
+        {
+            const auto& c = *cmd.second;
+            auto& s = stats.Command(cmd.first);
+            s.count += c.count.load(std::memory_order_relaxed);
+            s.errors += c.errors.load(std::memory_order_relaxed);
+            const auto max = c.max.load(std::memory_order_relaxed);
+            for (std::size_t b = 0; b < LatencyHistogram::Buckets; ++b)
+                s.latency.Add(b, c.latency[b].load(std::memory_order_relaxed), max);
+        }
+        stats.wrongCommands += wrongCommands.load(std::memory_order_relaxed);
+    }
+
+private:
+    using Counter = std::atomic<std::uint64_t>;
+
+    struct Counters
+    {
+        Counter count{ 0 };
+        Counter errors{ 0 };
+        Counter max{ 0 };
+        std::array<Counter, LatencyHistogram::Buckets> latency{};
+    };
+
+    // single writer: no need of an atomic read-modify-write
+    static void Increment(Counter& c)
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    mutable std::mutex mtx; // guards the insertions in commands
+    std::unordered_map<std::string, std::unique_ptr<Counters>> commands;
+    Counter wrongCommands{ 0 };
+};
+
+// The statistics of all the sessions of a Cli.
+// Each session records in its own shard. When the session ends,
+// its shard is merged in the statistics of the ended sessions.
+class StatsRegistry
+{
+public:
+    std::shared_ptr<StatsShard> NewShard()
+    {
+        auto shard = std::make_shared<StatsShard>();
+        std::lock_guard<std::mutex> lock(mtx);
+        shards.push_back(shard);
+        return shard;
+    }
+
+    void Retire(const std::shared_ptr<StatsShard>& shard)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        shard->CollectInto(retired);
+        shards.erase(std::remove(shards.begin(), shards.end(), shard), shards.end());
+    }
+
+    CliStats Collect() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CliStats result = retired;
+        for (const auto& s: shards)
+            s->CollectInto(result);
+        return result;
+    }
+
+private:
+    mutable std::mutex mtx;
+    std::vector<std::shared_ptr<StatsShard>> shards; // of the running sessions
+    CliStats retired; // of the ended sessions
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_STATSREGISTRY_H_
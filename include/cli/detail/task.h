@@ -0,0 +1,189 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef CLI_DETAIL_TASK_H_
+#define CLI_DETAIL_TASK_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cli
+{
+namespace detail
+{
+
+// A move-only `void()` callable.
+// The callables up to bufferSize bytes (e.g., a lambda capturing a few
+// pointers, or a std::function) are stored inside the object,
+// the bigger ones are allocated on the heap.
+class Task
+{
+public:
+    Task() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    Task(F&& f) // NOLINT (implicit conversion from any callable, like std::function)
+    {
+        using Fun = std::decay_t<F>;
+        if (IsNull(f)) return; // like std::function, an empty callable gives an empty Task
+        Init<Fun>(std::forward<F>(f), std::integral_constant<bool, Fits<Fun>()>());
+    }
+
+    Task(Task&& other) noexcept : ops(other.ops)
+    {
+        if (ops)
+        {
+            ops->move(&other.buffer, &buffer);
+            other.ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            if (other.ops)
+            {
+                other.ops->move(&other.buffer, &buffer);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Reset(); }
+
+    explicit operator bool() const noexcept { return ops != nullptr; }
+
+    void operator()() { ops->invoke(&buffer); }
+
+private:
+    static constexpr std::size_t bufferSize = 6 * sizeof(void*);
+    using Buffer = std::aligned_storage_t<bufferSize, alignof(std::max_align_t)>;
+
+    struct Ops
+    {
+        void (*invoke)(void*);
+        void (*move)(void* from, void* to) noexcept; // and destroys from
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename F>
+    static bool IsNull(const F& /*f*/) { return false; }
+    template <typename R, typename ... Args>
+    static bool IsNull(const std::function<R(Args...)>& f) { return !f; }
+    template <typename R, typename ... Args>
+    static bool IsNull(R (* const& f)(Args...)) { return f == nullptr; }
+
+    template <typename Fun>
+    static constexpr bool Fits()
+    {
+        return sizeof(Fun) <= bufferSize &&
+               alignof(Buffer) % alignof(Fun) == 0 &&
+               std::is_nothrow_move_constructible<Fun>::value;
+    }
+
+    // the callable inside the buffer
+    template <typename Fun>
+    struct Local
+    {
+        static Fun* Get(void* b) { return static_cast<Fun*>(b); }
+        static void Invoke(void* b) { (*Get(b))(); }
+        static void Move(void* from, void* to) noexcept
+        {
+            ::new (to) Fun(std::move(*Get(from)));
+            Get(from)->~Fun();
+        }
+        static void Destroy(void* b) noexcept { Get(b)->~Fun(); }
+        static const Ops* Table()
+        {
+            static const Ops ops{ &Invoke, &Move, &Destroy };
+            return &ops;
+        }
+    };
+
+    // the buffer contains a pointer to the callable
+    template <typename Fun>
+    struct Remote
+    {
+        static Fun*& Get(void* b) { return *static_cast<Fun**>(b); }
+        static void Invoke(void* b) { (*Get(b))(); }
+        static void Move(void* from, void* to) noexcept
+        {
+            ::new (to) Fun*(Get(from));
+        }
+        static void Destroy(void* b) noexcept { delete Get(b); }
+        static const Ops* Table()
+        {
+            static const Ops ops{ &Invoke, &Move, &Destroy };
+            return &ops;
+        }
+    };
+
+    template <typename Fun, typename F>
+    void Init(F&& f, std::true_type /*fits*/)
+    {
+        ::new (&buffer) Fun(std::forward<F>(f));
+        ops = Local<Fun>::Table();
+    }
+
+    template <typename Fun, typename F>
+    void Init(F&& f, std::false_type /*fits*/)
+    {
+        ::new (&buffer) Fun*(new Fun(std::forward<F>(f)));
+        ops = Remote<Fun>::Table();
+    }
+
+    void Reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(&buffer);
+            ops = nullptr;
+        }
+    }
+
+    const Ops* ops = nullptr;
+    Buffer buffer;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_TASK_H_
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef CLI_DETAIL_TELNETSCANNER_H_
+#define CLI_DETAIL_TELNETSCANNER_H_
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CLI_TELNETSCANNER_USE_SSE2
+#endif
+
+namespace cli
+{
+namespace detail
+{
+
+// Returns true if c needs to be processed on its own by the telnet session:
+// control chars, DEL and IAC (0xFF).
+// All other bytes are text, passed to the terminal as they are.
+inline bool IsTelnetSpecial(char c)
+{
+    const auto u = static_cast<unsigned char>(c);
+    return u < 0x20 || u == 0x7F || u == 0xFF;
+}
+
+// Returns a pointer to the first special char in [first, last),
+// or last if there is none.
+inline const char* FindTelnetSpecial(const char* first, const char* last)
+{
+#ifdef CLI_TELNETSCANNER_USE_SSE2
+    const __m128i maxControl = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i iac = _mm_set1_epi8(static_cast<char>(0xFF));
+    while (last - first >= 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        // unsigned v <= 0x1F  <=>  min(v, 0x1F) == v
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, maxControl), v);
+        const __m128i special = _mm_or_si128(control, _mm_or_si128(_mm_cmpeq_epi8(v, del), _mm_cmpeq_epi8(v, iac)));
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            int i = 0;
+            while ((mask & (1 << i)) == 0) ++i;
+            return first + i;
+        }
+        first += 16;
+    }
+#endif
+    while (first != last && !IsTelnetSpecial(*first))
+        ++first;
+    return first;
+}
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_TELNETSCANNER_H_
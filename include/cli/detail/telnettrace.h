@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef CLI_DETAIL_TELNETTRACE_H_
+#define CLI_DETAIL_TELNETTRACE_H_
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace cli
+{
+namespace detail
+{
+
+// Records the telnet protocol events of the sessions in a circular buffer,
+// so that tracing doesn't depend on the speed of any output stream.
+// When the buffer is full the oldest events are overwritten.
+class TelnetTrace
+{
+public:
+    enum class Event { data, command, will, wont, do_, dont, sub, error };
+
+    explicit TelnetTrace(std::size_t capacity) : entries(capacity == 0 ? 1 : capacity) {}
+
+    // non copyable
+    TelnetTrace(const TelnetTrace&) = delete;
+    TelnetTrace& operator=(const TelnetTrace&) = delete;
+
+    // returns a new id to tell the sessions apart in the trace
+    std::size_t NewSession()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return ++lastSession;
+    }
+
+    void Record(std::size_t session, Event event, char value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        entries[next] = Entry{ session, event, static_cast<unsigned char>(value) };
+        next = (next + 1) % entries.size();
+        if (size < entries.size()) ++size;
+    }
+
+    // writes the recorded events on out, from the oldest one
+    void Dump(std::ostream& out) const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        const std::size_t first = (next + entries.size() - size) % entries.size();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const Entry& e = entries[(first + i) % entries.size()];
+            out << "session " << e.session << ": " << Name(e.event) << ' ' << static_cast<unsigned int>(e.value) << '\n';
+        }
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        next = 0;
+        size = 0;
+    }
+
+private:
+    struct Entry
+    {
+        std::size_t session;
+        Event event;
+        unsigned char value;
+    };
+
+    static const char* Name(Event event)
+    {
+        switch (event)
+        {
+            case Event::data: return "data";
+            case Event::command: return "command";
+            case Event::will: return "will";
+            case Event::wont: return "wont";
+            case Event::do_: return "do";
+            case Event::dont: return "dont";
+            case Event::sub: return "sub";
+            case Event::error: return "error";
+        }
+        return "?";
+    }
+
+    mutable std::mutex mtx;
+    std::vector<Entry> entries;
+    std::size_t next = 0;
+    std::size_t size = 0;
+    std::size_t lastSession = 0;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_TELNETTRACE_H_
@@ -47,7 +47,9 @@ enum class Symbol
     down,
     tab,
     eof,
-    clear
+    clear,
+    search,
+    interrupt
 };
 
 template <typename SCREEN>
@@ -81,6 +83,26 @@ class Terminal
 
     std::string GetLine() const { return currentLine; }
 
+    // inserts text at the cursor position, updating the screen at once
+    void InsertText(const char* text, std::size_t size)
+    {
+        const auto pos = static_cast<std::string::difference_type>(position);
+
+        // output the new text:
+        out << beforeInput;
+        out.write(text, static_cast<std::streamsize>(size));
+        // and the rest of the string:
+        out << std::string(currentLine.begin() + pos, currentLine.end())
+            << afterInput;
+
+        // go back to the original position
+        out << std::string(currentLine.size() - position, '\b') << std::flush;
+
+        // update the buffer and cursor position:
+        currentLine.insert(position, text, size);
+        position += size;
+    }
+
     std::pair<Symbol, std::string> Keypressed(std::pair<KeyType, char> k)
     {
         switch (k.first)
@@ -139,28 +161,22 @@ class Terminal
                 return std::make_pair(Symbol::command, cmd);
             }
             break;
+            case KeyType::interrupt:
+            {
+                // the line is discarded
+                out << "^C\r\n";
+                currentLine.clear();
+                position = 0;
+                return std::make_pair(Symbol::interrupt, std::string{});
+            }
+            break;
             case KeyType::ascii:
             {
                 const char c = static_cast<char>(k.second);
                 if (c == '\t')
                     return std::make_pair(Symbol::tab, std::string());
                 else
-                {
-                    const auto pos = static_cast<std::string::difference_type>(position);
-
-                    // output the new char:
-                    out << beforeInput << c;
-                    // and the rest of the string:
-                    out << std::string(currentLine.begin() + pos, currentLine.end())
-                        << afterInput;
-
-                    // go back to the original position
-                    out << std::string(currentLine.size() - position, '\b') << std::flush;
-
-                    // update the buffer and cursor position:
-                    currentLine.insert(currentLine.begin() + pos, c);
-                    ++position;
-                }
+                    InsertText(&c, 1);
 
                 break;
             }
@@ -200,6 +216,9 @@ class Terminal
             case KeyType::clear:
                 return std::make_pair(Symbol::clear, std::string());
                 break;
+            case KeyType::search:
+                return std::make_pair(Symbol::search, std::string());
+                break;
             case KeyType::ignored:
                 // TODO
                 break;
@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef CLI_DETAIL_TIMERQUEUE_H_
+#define CLI_DETAIL_TIMERQUEUE_H_
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../scheduler.h"
+
+namespace cli
+{
+namespace detail
+{
+
+// The timers of a scheduler, in a min-heap on the expiry time.
+// Not thread safe: the scheduler must serialize the access.
+class TimerQueue
+{
+public:
+    using Clock = Scheduler::Clock;
+
+    bool Empty() const { return timers.empty(); }
+
+    // the expiry of the first timer (the queue must not be empty)
+    Clock::time_point NextExpiry() const { return timers.front().when; }
+
+    void Push(Clock::time_point when, const std::function<void()>& task, const std::shared_ptr<TimerHandle::State>& state)
+    {
+        timers.push_back(Timer{ when, ++seq, task, state });
+        std::push_heap(timers.begin(), timers.end(), Later());
+    }
+
+    // takes the task of the first timer expired at now, skipping the cancelled ones
+    bool PopExpired(Clock::time_point now, std::function<void()>& task)
+    {
+        while (!timers.empty() && timers.front().when <= now)
+        {
+            std::pop_heap(timers.begin(), timers.end(), Later());
+            Timer& timer = timers.back();
+            const bool cancelled = timer.state->cancelled;
+            if (!cancelled)
+                task = std::move(timer.task);
+            timers.pop_back();
+            if (!cancelled)
+                return true;
+        }
+        return false;
+    }
+
+    // The cancelled timers are removed when they expire or, when they can be
+    // the majority, all at once. cancelled is the number of timers cancelled
+    // since the last call that purged (some of them can be already expired).
+    // Returns true if it purged.
+    bool Purge(std::size_t cancelled)
+    {
+        if (cancelled <= 64 || cancelled <= timers.size() / 2)
+            return false;
+        timers.erase(
+            std::remove_if(timers.begin(), timers.end(), [](const Timer& t){ return t.state->cancelled.load(); }),
+            timers.end()
+        );
+        std::make_heap(timers.begin(), timers.end(), Later());
+        return true;
+    }
+
+private:
+    struct Timer
+    {
+        Clock::time_point when;
+        unsigned long long seq; // timers with the same expiry run in order of submission
+        std::function<void()> task;
+        std::shared_ptr<TimerHandle::State> state;
+    };
+
+    struct Later
+    {
+        bool operator()(const Timer& a, const Timer& b) const
+        {
+            return a.when > b.when || (a.when == b.when && a.seq > b.seq);
+        }
+    };
+
+    std::vector<Timer> timers;
+    unsigned long long seq = 0;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_TIMERQUEUE_H_
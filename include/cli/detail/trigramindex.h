@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef CLI_DETAIL_TRIGRAMINDEX_H_
+#define CLI_DETAIL_TRIGRAMINDEX_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cli
+{
+namespace detail
+{
+
+// An index of the trigrams (sequences of 3 chars) of a list of strings,
+// to find quickly the strings containing a text.
+// The single chars and the pairs of chars are indexed as well,
+// so that also the texts shorter than a trigram don't need a scan.
+// The index doesn't store the strings: they're provided by a function
+// entry(i) returning a pair (data, size) for the string i.
+class TrigramIndex
+{
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    template <typename F>
+    TrigramIndex(std::size_t size, F&& entry)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const auto e = entry(i);
+            for (std::size_t n = 1; n <= 3; ++n)
+                for (std::size_t j = 0; j + n <= e.second; ++j)
+                {
+                    auto& list = postings[Gram(e.first + j, n)];
+                    if (list.empty() || list.back() != i) // each string only once
+                        list.push_back(static_cast<Id>(i));
+                }
+        }
+    }
+
+    // Returns the greatest i < before such that the string i contains text,
+    // or npos if there is none.
+    template <typename F>
+    std::size_t Find(const std::string& text, std::size_t before, F&& entry) const
+    {
+        if (text.empty())
+            return Scan(text, before, entry);
+
+        // the candidates are the strings in the shortest posting list
+        // of the trigrams of text (or of text itself, when it's shorter)
+        const std::size_t n = std::min<std::size_t>(text.size(), 3);
+        const std::vector<Id>* shortest = nullptr;
+        for (std::size_t j = 0; j + n <= text.size(); ++j)
+        {
+            const auto it = postings.find(Gram(text.data() + j, n));
+            if (it == postings.end())
+                return npos; // no string contains these chars
+            if (shortest == nullptr || it->second.size() < shortest->size())
+                shortest = &it->second;
+        }
+        auto candidate = std::lower_bound(shortest->begin(), shortest->end(), before);
+        while (candidate != shortest->begin())
+        {
+            --candidate;
+            if (Contains(entry(*candidate), text))
+                return *candidate;
+        }
+        return npos;
+    }
+
+    // Returns the greatest i < before such that the string i contains text,
+    // or npos if there is none, without using an index.
+    template <typename F>
+    static std::size_t Scan(const std::string& text, std::size_t before, F&& entry)
+    {
+        for (std::size_t i = before; i > 0; --i)
+            if (Contains(entry(i-1), text))
+                return i-1;
+        return npos;
+    }
+
+private:
+    using Id = std::uint32_t;
+
+    // the key of the n chars starting from s (n <= 3)
+    static std::uint32_t Gram(const char* s, std::size_t n)
+    {
+        std::uint32_t key = static_cast<std::uint32_t>(n) << 24; // keeps apart the lengths
+        for (std::size_t i = 0; i < n; ++i)
+            key |= static_cast<std::uint32_t>(static_cast<unsigned char>(s[i])) << (8 * (n - 1 - i));
+        return key;
+    }
+
+    static bool Contains(const std::pair<const char*, std::size_t>& e, const std::string& text)
+    {
+        return std::search(e.first, e.first + e.second, text.begin(), text.end()) != e.first + e.second || text.empty();
+    }
+
+    std::unordered_map<std::uint32_t, std::vector<Id>> postings;
+};
+
+} // namespace detail
+} // namespace cli
+
+#endif // CLI_DETAIL_TRIGRAMINDEX_H_
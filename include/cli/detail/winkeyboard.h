@@ -138,9 +138,11 @@ private:
             case EOF:
             case 4:  // EOT ie CTRL-D
             case 26: // CTRL-Z
-            case 3:  // CTRL-C
                 return std::make_pair(KeyType::eof, ' ');
                 break;
+            case 3:  // CTRL-C
+                return std::make_pair(KeyType::interrupt, ' ');
+                break;
 
             case 224: // symbol
             {
@@ -163,6 +165,9 @@ private:
             case 12: // CTRL-L
                 return std::make_pair(KeyType::clear, ' ');
                 break;
+            case 18: // CTRL-R
+                return std::make_pair(KeyType::search, ' ');
+                break;
             case 13:
                 return std::make_pair(KeyType::ret, c);
                 break;
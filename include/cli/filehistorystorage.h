@@ -31,54 +31,391 @@
 #define CLI_FILEHISTORYSTORAGE_H_
 
 #include "historystorage.h"
+#include "detail/filelock.h"
+#include "detail/filestamp.h"
+#include "detail/platform.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#if defined(CLI_OS_WIN)
+    #include <io.h> // _commit
+#else
+    #include <unistd.h> // fsync
+#endif
 
 namespace cli
 {
 
+/**
+ * @brief FileHistoryStorage is a persistent history: the commands are stored
+ * in a file, so that they're preserved after the application exits and can be
+ * shared by many applications.
+ *
+ * The file is an append-only journal: each call to `Store` appends the new
+ * commands with a single write, as length-prefixed records (`<size>:<command>`,
+ * one per line). A record partially written (e.g., because of a crash) is
+ * skipped when the file is loaded.
+ * When the file holds more than twice the maximum number of commands,
+ * a background thread compacts it, keeping only the most recent commands.
+ * The applications sharing the file lock `<file name>.lock`, so that
+ * the commands appended while another application compacts the file are not lost.
+ * The files written by the previous versions of the library (one command per line)
+ * are converted on the first `Store`.
+ */
 class FileHistoryStorage : public HistoryStorage
 {
 public:
-    explicit FileHistoryStorage(std::string _fileName, std::size_t size = 1000) : 
+
+    /// The durability of the commands stored
+    enum class Sync
+    {
+        none,   ///< the data is written when `Store` returns, but the OS can cache it
+        always  ///< the file is synced to the disk before `Store` returns
+    };
+
+    explicit FileHistoryStorage(std::string _fileName, std::size_t size = 1000, Sync _sync = Sync::none) :
         maxSize(size),
-        fileName(std::move(_fileName))
+        fileName(std::move(_fileName)),
+        sync(_sync)
     {
     }
+    ~FileHistoryStorage() override
+    {
+        WaitCompaction();
+    }
+
+    // non copyable
+    FileHistoryStorage(const FileHistoryStorage&) = delete;
+    FileHistoryStorage& operator=(const FileHistoryStorage&) = delete;
+
     void Store(const std::vector<std::string>& cmds) override
     {
-        using dt = std::vector<std::string>::difference_type;
-        auto commands = Commands();
-        commands.insert(commands.end(), cmds.begin(), cmds.end());
-        if (commands.size() > maxSize)
-            commands.erase(
-                commands.begin(), 
-                commands.begin() + static_cast<dt>(commands.size() - maxSize)
-            );
-        std::ofstream f(fileName, std::ios_base::out);
-            for (const auto& line: commands)
-                f << line << '\n';
+        if (cmds.empty())
+            return;
+
+        bool convert = false;
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            if (!scanned)
+                Scan();
+            convert = legacy;
+        }
+        if (convert)
+        {
+            // converts the file to the journal format, before appending to it
+            WaitCompaction();
+            Compact();
+        }
+
+        bool compact = false;
+        {
+            // the appends don't exclude each other (they're single writes),
+            // but a compaction of another application would lose them
+            const detail::FileLock fileLock(LockFileName(), detail::FileLock::Mode::shared);
+            std::lock_guard<std::mutex> lck(mtx);
+            std::FILE* f = std::fopen(fileName.c_str(), "a+b");
+            if (f == nullptr)
+                return;
+            std::string data;
+            if (std::fseek(f, -1, SEEK_END) != 0)
+                data = Header(); // empty file
+            else if (std::fgetc(f) != '\n')
+                data = '\n'; // the last record was truncated
+            for (const auto& cmd: cmds)
+            {
+                if (legacy) // the conversion failed
+                    data += cmd + '\n';
+                else
+                    AppendRecord(data, cmd);
+            }
+            std::fseek(f, 0, SEEK_END); // required between a read and a write
+            std::fwrite(data.data(), 1, data.size(), f);
+            Close(f);
+            entries += cmds.size();
+            if (entries > 2 * maxSize && !compacting)
+                compacting = compact = true;
+        }
+
+        if (compact)
+        {
+            std::lock_guard<std::mutex> threadLock(compactionMtx);
+            if (compaction.joinable())
+                compaction.join();
+            compaction = std::thread([this]() noexcept
+            {
+                try
+                {
+                    Compact();
+                }
+                catch (...)
+                {
+                    // the file will be compacted next time
+                    std::lock_guard<std::mutex> lock(mtx);
+                    compacting = false;
+                }
+            });
+        }
     }
     std::vector<std::string> Commands() const override
     {
+        const auto snapshot = Snapshot();
         std::vector<std::string> commands;
-        std::ifstream in(fileName);
-        if (in)
+        commands.reserve(snapshot->Size());
+        for (std::size_t i = 0; i < snapshot->Size(); ++i)
+            commands.push_back(snapshot->At(i));
+        return commands;
+    }
+    // The snapshot reads the file with a single read, and keeps the last
+    // commands in one buffer.
+    // The same snapshot is returned until the file changes (also
+    // because of other applications), so that all the sessions share it.
+    std::shared_ptr<const HistorySnapshot> Snapshot() const override
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        const auto stamp = detail::GetFileStamp(fileName); // before reading the file
+        if (!snapshot || stamp != snapshotStamp)
         {
-            std::string line;
-            while (std::getline(in, line))
-                commands.push_back(line);
+            snapshot = std::make_shared<FileSnapshot>(Read(0), maxSize);
+            snapshotStamp = stamp;
         }
-        return commands;
+        return snapshot;
     }
     void Clear() override
     {
-        std::ofstream f(fileName, std::ios_base::out | std::ios_base::trunc);
+        WaitCompaction();
+        const detail::FileLock fileLock(LockFileName(), detail::FileLock::Mode::exclusive);
+        std::lock_guard<std::mutex> lck(mtx);
+        // The file is replaced or removed, but never truncated,
+        // so that the other applications never read it partially written.
+        if (!Replace(std::string()) && std::remove(fileName.c_str()) != 0 && detail::GetFileStamp(fileName).exists)
+            throw std::runtime_error("cannot clear the history file " + fileName);
+        scanned = true;
+        legacy = false;
+        entries = 0;
     }
 
 private:
+
+    using Records = std::vector<std::pair<const char*, std::size_t>>;
+
+    // the last commands of the file
+    class FileSnapshot : public HistorySnapshot
+    {
+    public:
+        FileSnapshot(const std::string& content, std::size_t maxSize)
+        {
+            Records all;
+            Parse(content.data(), content.data() + content.size(), all, IsLegacy(content));
+            const std::size_t first = (all.size() > maxSize ? all.size() - maxSize : 0);
+            std::size_t total = 0;
+            for (std::size_t i = first; i < all.size(); ++i)
+                total += all[i].second;
+            // the commands are copied in commands (reserved, so that they don't move)
+            commands.reserve(total);
+            records.reserve(all.size() - first);
+            for (std::size_t i = first; i < all.size(); ++i)
+            {
+                records.emplace_back(commands.data() + commands.size(), all[i].second);
+                commands.append(all[i].first, all[i].second);
+            }
+        }
+        std::size_t Size() const override { return records.size(); }
+        std::string At(std::size_t i) const override { return std::string(records[i].first, records[i].second); }
+        // uses an index of the commands, built the first time
+        std::size_t Find(const std::string& text, std::size_t before) const override
+        {
+            const auto entry = [this](std::size_t n){ return records[n]; };
+            std::call_once(indexBuilt, [&](){ index = std::make_unique<detail::TrigramIndex>(records.size(), entry); });
+            const auto i = index->Find(text, std::min(before, Size()), entry);
+            return i == detail::TrigramIndex::npos ? Size() : i;
+        }
+    private:
+        std::string commands;
+        Records records; // point into commands
+        mutable std::once_flag indexBuilt;
+        mutable std::unique_ptr<detail::TrigramIndex> index;
+    };
+
+    static const char* Header() { return "#cli-history 1\n"; }
+
+    static void AppendRecord(std::string& data, const std::string& cmd)
+    {
+        data += std::to_string(cmd.size());
+        data += ':';
+        data += cmd;
+        data += '\n';
+    }
+
+    // true if the content of the file is in the format of the previous versions (one command per line)
+    static bool IsLegacy(const char* begin, const char* end)
+    {
+        const std::size_t size = static_cast<std::size_t>(end - begin);
+        const std::size_t headerSize = std::char_traits<char>::length(Header());
+        return size != 0 && (size < headerSize || !std::equal(begin, begin + headerSize, Header()));
+    }
+    static bool IsLegacy(const std::string& content)
+    {
+        return IsLegacy(content.data(), content.data() + content.size());
+    }
+
+    // puts in records the commands in [begin, end)
+    static void Parse(const char* begin, const char* end, Records& records, bool legacy)
+    {
+        while (begin != end)
+        {
+            const char* eol = std::find(begin, end, '\n');
+            if (legacy)
+            {
+                records.emplace_back(begin, static_cast<std::size_t>(eol - begin));
+                begin = (eol == end ? end : eol + 1);
+                continue;
+            }
+            // <size>:<command>\n
+            std::size_t size = 0;
+            const char* p = begin;
+            while (p != end && *p >= '0' && *p <= '9' && size <= static_cast<std::size_t>(end - begin))
+                size = size * 10 + static_cast<std::size_t>(*p++ - '0');
+            if (p != begin && p != end && *p == ':' && static_cast<std::size_t>(end - p) > size + 1 && p[size + 1] == '\n')
+            {
+                records.emplace_back(p + 1, size);
+                begin = p + size + 2;
+            }
+            else // not a record (e.g., the header or a record truncated): skip the line
+                begin = (eol == end ? end : eol + 1);
+        }
+    }
+
+    // returns the content of the file starting from offset
+    std::string Read(std::size_t offset) const
+    {
+        std::string content;
+        std::ifstream in(fileName, std::ios_base::in | std::ios_base::binary);
+        if (!in)
+            return content;
+        in.seekg(0, std::ios_base::end);
+        const auto size = static_cast<std::size_t>(in.tellg());
+        if (size <= offset)
+            return content;
+        content.resize(size - offset);
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(&content[0], static_cast<std::streamsize>(content.size()));
+        content.resize(static_cast<std::size_t>(in.gcount()));
+        return content;
+    }
+
+    // counts the records in the file (mtx must be locked)
+    void Scan()
+    {
+        Records records;
+        const std::string content = Read(0);
+        legacy = IsLegacy(content);
+        Parse(content.data(), content.data() + content.size(), records, legacy);
+        entries = records.size();
+        scanned = true;
+    }
+
+    // Rewrites the file with the last maxSize commands.
+    // The file is read without locking, then the commands appended in the
+    // meantime are read with the locks held, before replacing the file.
+    void Compact()
+    {
+        const auto stamp = detail::GetFileStamp(fileName); // before reading the file
+        std::string content = Read(0);
+
+        const detail::FileLock fileLock(LockFileName(), detail::FileLock::Mode::exclusive);
+        std::lock_guard<std::mutex> lck(mtx);
+        compacting = false; // Store can't start a new compaction until this one ends
+        // Another application replaced (e.g., compacted) or truncated the file in the meantime:
+        // it must be read again (without the inode, we can't tell it).
+        const auto current = detail::GetFileStamp(fileName);
+        if (stamp.inode == 0 || current.inode != stamp.inode || current.size < static_cast<long long>(content.size()))
+            content = Read(0);
+        const bool legacyContent = IsLegacy(content);
+        Records records;
+        Parse(content.data(), content.data() + content.size(), records, legacyContent);
+        const std::string tail = Read(content.size());
+        Parse(tail.data(), tail.data() + tail.size(), records, content.empty() ? IsLegacy(tail) : legacyContent);
+        std::string data = Header();
+        const std::size_t first = (records.size() > maxSize ? records.size() - maxSize : 0);
+        for (std::size_t i = first; i < records.size(); ++i)
+            AppendRecord(data, std::string(records[i].first, records[i].second));
+        const std::size_t count = records.size() - first;
+
+        if (!Replace(data))
+            return;
+        legacy = false;
+        entries = count;
+    }
+
+    std::string LockFileName() const { return fileName + ".lock"; }
+
+    // atomically replaces the content of the file with data
+    bool Replace(const std::string& data)
+    {
+        const std::string tmpName = fileName + ".tmp";
+        std::FILE* f = std::fopen(tmpName.c_str(), "wb");
+        if (f == nullptr)
+            return false;
+        const bool written = (std::fwrite(data.data(), 1, data.size(), f) == data.size());
+        if (!Close(f) || !written)
+        {
+            std::remove(tmpName.c_str());
+            return false;
+        }
+#if defined(CLI_OS_WIN)
+        std::remove(fileName.c_str()); // rename doesn't replace an existing file
+#endif
+        if (std::rename(tmpName.c_str(), fileName.c_str()) != 0)
+        {
+            std::remove(tmpName.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // flushes (and syncs, according to the policy) and closes the file
+    bool Close(std::FILE* f) const
+    {
+        bool ok = (std::fflush(f) == 0);
+        if (ok && sync == Sync::always)
+        {
+#if defined(CLI_OS_WIN)
+            ok = (_commit(_fileno(f)) == 0);
+#else
+            ok = (fsync(fileno(f)) == 0);
+#endif
+        }
+        return (std::fclose(f) == 0) && ok;
+    }
+
+    void WaitCompaction()
+    {
+        std::lock_guard<std::mutex> lck(compactionMtx);
+        if (compaction.joinable())
+            compaction.join();
+    }
+
     const std::size_t maxSize;
     const std::string fileName;
+    const Sync sync;
+    mutable std::mutex mtx;
+    mutable std::shared_ptr<const HistorySnapshot> snapshot; // the last one returned
+    mutable detail::FileStamp snapshotStamp; // the version of the file in snapshot
+    bool scanned = false; // the file has been read, so entries and legacy are valid
+    bool legacy = false; // the file is in the format of the previous versions
+    std::size_t entries = 0; // number of records in the file
+    bool compacting = false;
+    std::mutex compactionMtx; // guards the thread object (the thread doesn't lock it)
+    std::thread compaction;
 };
 
 } // namespace cli
@@ -30,12 +30,63 @@
 #ifndef CLI_HISTORYSTORAGE_H_
 #define CLI_HISTORYSTORAGE_H_
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <utility>
+#include "detail/trigramindex.h"
 
 namespace cli
 {
 
+// An immutable sequence of commands, that can be shared among sessions
+// (and threads) without copying the commands.
+class HistorySnapshot
+{
+public:
+    virtual ~HistorySnapshot() = default;
+    // Returns the number of commands
+    virtual std::size_t Size() const = 0;
+    // Returns the command at index i (0 is the oldest command)
+    virtual std::string At(std::size_t i) const = 0;
+    // Returns the index of the newest command containing text among the
+    // ones with index < before, or Size() if there is none.
+    // The default implementation scans all the commands.
+    virtual std::size_t Find(const std::string& text, std::size_t before) const
+    {
+        std::string cmd;
+        const auto i = detail::TrigramIndex::Scan(text, std::min(before, Size()), [&](std::size_t n)
+        {
+            cmd = At(n);
+            return std::make_pair(cmd.data(), cmd.size());
+        });
+        return i == detail::TrigramIndex::npos ? Size() : i;
+    }
+};
+
+// A HistorySnapshot holding the commands in a vector
+class VectorHistorySnapshot : public HistorySnapshot
+{
+public:
+    explicit VectorHistorySnapshot(std::vector<std::string> _commands) : commands(std::move(_commands)) {}
+    std::size_t Size() const override { return commands.size(); }
+    std::string At(std::size_t i) const override { return commands[i]; }
+    // uses an index of the commands, built the first time
+    std::size_t Find(const std::string& text, std::size_t before) const override
+    {
+        const auto entry = [this](std::size_t n){ return std::make_pair(commands[n].data(), commands[n].size()); };
+        std::call_once(indexBuilt, [&](){ index = std::make_unique<detail::TrigramIndex>(commands.size(), entry); });
+        const auto i = index->Find(text, std::min(before, Size()), entry);
+        return i == detail::TrigramIndex::npos ? Size() : i;
+    }
+private:
+    const std::vector<std::string> commands;
+    mutable std::once_flag indexBuilt;
+    mutable std::unique_ptr<detail::TrigramIndex> index;
+};
+
 class HistoryStorage
 {
 public:
@@ -44,6 +95,13 @@ public:
     virtual void Store(const std::vector<std::string>& commands) = 0;
     // Returns all the commands stored
     virtual std::vector<std::string> Commands() const = 0;
+    // Returns all the commands stored, as a snapshot that doesn't change
+    // after the following calls to Store.
+    // The default implementation copies the result of Commands()
+    virtual std::shared_ptr<const HistorySnapshot> Snapshot() const
+    {
+        return std::make_shared<VectorHistorySnapshot>(Commands());
+    }
     // Clear the whole content of the storage
     // After calling this method, Commands() returns the empty vector
     virtual void Clear() = 0;
@@ -0,0 +1,284 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef CLI_LOCKFREESCHEDULER_H_
+#define CLI_LOCKFREESCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "scheduler.h"
+#include "detail/task.h"
+#include "detail/timerqueue.h"
+
+namespace cli
+{
+
+/**
+ * @brief The LockFreeScheduler is a thread-safe scheduler with the same
+ * interface of LoopScheduler, optimized for many threads posting tasks.
+ *
+ * The tasks are stored in a lock-free multi-producer single-consumer queue,
+ * without copying them, so Post never blocks the producers on a mutex.
+ * The thread running the tasks sleeps on a condition variable when there is
+ * nothing to do, and Post only takes the mutex to wake it up.
+ * The tasks must be run by one thread at a time.
+ * The timers are kept by the thread running the tasks: PostAt hands them
+ * over through a short critical section.
+ */
+class LockFreeScheduler : public Scheduler
+{
+public:
+    LockFreeScheduler() = default;
+    ~LockFreeScheduler() override
+    {
+        Stop();
+        while (auto node = Pop())
+            delete node;
+    }
+
+    // non copyable
+    LockFreeScheduler(const LockFreeScheduler&) = delete;
+    LockFreeScheduler& operator=(const LockFreeScheduler&) = delete;
+
+    void Stop()
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        running = false;
+        sleeping = false;
+        cv.notify_all();
+    }
+
+    void Run()
+    {
+        while( ExecOne() ) {};
+    }
+
+    bool Stopped() const
+    {
+        return !running;
+    }
+
+    void Post(const std::function<void()>& f) override
+    {
+        Push(new Node(f));
+    }
+
+    // accepts also move-only function objects
+    template <typename F>
+    void Post(F&& f)
+    {
+        Push(new Node(std::forward<F>(f)));
+    }
+
+    TimerHandle PostAt(Clock::time_point t, const std::function<void()>& f) override
+    {
+        auto state = std::make_shared<TimerHandle::State>();
+        state->onCancel = [this](){ ++cancelledTimers; };
+        {
+            std::lock_guard<std::mutex> lck(newTimersMtx);
+            newTimers.push_back(NewTimer{ t, f, state });
+            hasNewTimers = true;
+        }
+        Wake();
+        return TimerHandle(state);
+    }
+
+    // runs a task or an expired timer, waiting for them
+    bool ExecOne()
+    {
+        while (running)
+        {
+            if (ExecTimer())
+                return true;
+            std::unique_ptr<Node> node(Pop());
+            if (node)
+            {
+                if (node->task)
+                    node->task();
+                return true;
+            }
+            Park();
+        }
+        return false;
+    }
+
+    // runs a task or an expired timer, if any
+    bool PollOne()
+    {
+        if (!running)
+            return false;
+        if (ExecTimer())
+            return true;
+        std::unique_ptr<Node> node(Pop());
+        if (!node)
+            return false;
+        if (node->task)
+            node->task();
+        return true;
+    }
+
+private:
+
+    struct Node
+    {
+        Node() = default;
+        explicit Node(detail::Task t) : task(std::move(t)) {}
+        std::atomic<Node*> next{ nullptr };
+        detail::Task task;
+    };
+
+    // Dmitry Vyukov's intrusive MPSC queue:
+    // the producers append to head, the consumer takes from tail.
+
+    void Push(Node* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+        Wake();
+    }
+
+    // returns nullptr if the queue is empty
+    // (or a producer is in the middle of a Push: it will wake the consumer)
+    Node* Pop()
+    {
+        Node* t = tail;
+        Node* next = t->next.load(std::memory_order_acquire);
+        if (t == &stub)
+        {
+            if (next == nullptr)
+                return nullptr;
+            tail = next;
+            t = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr)
+        {
+            tail = next;
+            return t;
+        }
+        if (t != head.load(std::memory_order_acquire))
+            return nullptr;
+        // t is the last node: put the stub behind it to take it out
+        stub.next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head.exchange(&stub, std::memory_order_acq_rel);
+        prev->next.store(&stub, std::memory_order_release);
+        next = t->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            tail = next;
+            return t;
+        }
+        return nullptr;
+    }
+
+    // runs the first expired timer, if any
+    bool ExecTimer()
+    {
+        if (hasNewTimers)
+        {
+            std::vector<NewTimer> added;
+            {
+                std::lock_guard<std::mutex> lck(newTimersMtx);
+                added.swap(newTimers);
+                hasNewTimers = false;
+            }
+            for (auto& t: added)
+                timers.Push(t.when, t.task, t.state);
+        }
+        if (timers.Purge(cancelledTimers))
+            cancelledTimers = 0;
+        std::function<void()> task;
+        if (!timers.PopExpired(Clock::now(), task))
+            return false;
+        if (task)
+            task();
+        return true;
+    }
+
+    // the consumer waits for a Push or a PostAt, or for the first timer to expire
+    void Park()
+    {
+        std::unique_lock<std::mutex> lck(mtx);
+        sleeping.store(true);
+        // pairs with the fence in Wake: either we see the new node (or timer),
+        // or the producer sees sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (tail->next.load(std::memory_order_acquire) != nullptr || tail != head.load(std::memory_order_acquire) || hasNewTimers)
+        {
+            sleeping.store(false);
+            return;
+        }
+        auto awake = [this](){ return !sleeping.load() || !running; };
+        if (timers.Empty())
+            cv.wait(lck, awake);
+        else
+            cv.wait_until(lck, timers.NextExpiry(), awake);
+        sleeping.store(false);
+    }
+
+    void Wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load() && sleeping.exchange(false))
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            cv.notify_one();
+        }
+    }
+
+    Node stub;
+    std::atomic<Node*> head{ &stub };
+    Node* tail{ &stub }; // only used by the consumer
+    std::atomic<bool> running{ true };
+    std::atomic<bool> sleeping{ false };
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    struct NewTimer
+    {
+        Clock::time_point when;
+        std::function<void()> task;
+        std::shared_ptr<TimerHandle::State> state;
+    };
+    std::mutex newTimersMtx;
+    std::vector<NewTimer> newTimers; // submitted by PostAt, not yet in timers
+    std::atomic<bool> hasNewTimers{ false };
+    std::atomic<std::size_t> cancelledTimers{ 0 };
+    detail::TimerQueue timers; // only used by the consumer
+};
+
+} // namespace cli
+
+#endif // CLI_LOCKFREESCHEDULER_H_
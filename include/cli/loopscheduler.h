@@ -30,11 +30,17 @@
 #ifndef CLI_LOOPSCHEDULER_H_
 #define CLI_LOOPSCHEDULER_H_
 
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <iterator>
+#include <limits>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include "scheduler.h"
+#include "detail/timerqueue.h"
 
 namespace cli
 {
@@ -42,11 +48,22 @@ namespace cli
 /**
  * @brief The LoopScheduler is a simple thread-safe scheduler
  * 
+ * The tasks can be executed one at a time (`ExecOne`, `PollOne`) or in batches
+ * (`RunBatch`, `PollAll`), taking them from the queue with a single lock.
+ * Optionally, the queue of tasks can be bounded: in this case `Post` blocks
+ * the producers while the queue is full.
  */
 class LoopScheduler : public Scheduler
 {
 public:
     LoopScheduler() = default;
+
+    /// Creates a scheduler holding at most maxPending tasks: when the queue
+    /// is full, `Post` blocks until a task is taken from the queue.
+    /// `Post` never blocks when it's called by the thread running the tasks
+    /// (to avoid deadlocks) or after `Stop`.
+    explicit LoopScheduler(std::size_t _maxPending) : maxPending(_maxPending) {}
+
     ~LoopScheduler() override
     {
         Stop();
@@ -61,11 +78,12 @@ public:
         std::lock_guard<std::mutex> lck (mtx);
         running = false;
         cv.notify_all();
+        notFull.notify_all();
     }
 
     void Run()
     {
-        while( ExecOne() ) {};
+        while( RunBatch() > 0 ) {};
     }
 
     bool Stopped() const
@@ -76,21 +94,39 @@ public:
 
     void Post(const std::function<void()>& f) override
     {
+        std::unique_lock<std::mutex> lck (mtx);
+        if (maxPending > 0 && tasks.size() >= maxPending && runner != std::this_thread::get_id())
+            notFull.wait(lck, [this](){ return !running || tasks.size() < maxPending; });
+        tasks.push_back(f);
+        cv.notify_all();
+    }
+
+    TimerHandle PostAt(Clock::time_point t, const std::function<void()>& f) override
+    {
+        auto state = std::make_shared<TimerHandle::State>();
+        state->onCancel = [this]()
+        {
+            std::lock_guard<std::mutex> lck (mtx);
+            if (timers.Purge(++cancelledTimers))
+                cancelledTimers = 0;
+        };
         std::lock_guard<std::mutex> lck (mtx);
-        tasks.push(f);
+        timers.Push(t, f, state);
         cv.notify_all();
+        return TimerHandle(state);
     }
 
+    // runs a task or an expired timer, waiting for them
     bool ExecOne()
     {
         std::function<void()> task;
         {
             std::unique_lock<std::mutex> lck(mtx);
-            cv.wait(lck, [this](){ return !running || !tasks.empty(); });
-            if (!running)
-                return false;
-            task = tasks.front();
-            tasks.pop();
+            do
+            {
+                if (!WaitReady(lck))
+                    return false;
+            } while (!PopReady(task)); // the expired timer can be cancelled in the meantime
         }
 
         if (task)
@@ -99,15 +135,15 @@ public:
         return true;
     }
 
+    // runs a task or an expired timer, if any
     bool PollOne()
     {
         std::function<void()> task;
         {
             std::lock_guard<std::mutex> lck(mtx);
-            if (!running || tasks.empty())
+            runner = std::this_thread::get_id();
+            if (!running || !PopReady(task))
                 return false;
-            task = tasks.front();
-            tasks.pop();
         }
 
         if (task)
@@ -116,11 +152,138 @@ public:
         return true;
     }
 
+    /// Waits for tasks or expired timers, then runs up to maxTasks (> 0) of them
+    /// taken from the queue at once. The tasks posted in the meantime run
+    /// in the next batch.
+    /// If a task throws, or the scheduler is stopped, the tasks not yet
+    /// executed are put back at the front of the queue.
+    /// Returns the number of tasks executed (0 when the scheduler is stopped).
+    std::size_t RunBatch(std::size_t maxTasks = std::numeric_limits<std::size_t>::max())
+    {
+        assert(maxTasks > 0);
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            do
+            {
+                if (!WaitReady(lck))
+                    return 0;
+            } while (!PopBatch(maxTasks)); // the expired timers can be cancelled in the meantime
+        }
+        return ExecBatch();
+    }
+
+    /// Runs the tasks and the expired timers until there are none left,
+    /// including the ones posted by the tasks themselves.
+    /// Returns the number of tasks executed.
+    std::size_t PollAll()
+    {
+        std::size_t executed = 0;
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                runner = std::this_thread::get_id();
+                if (!running || !PopBatch(std::numeric_limits<std::size_t>::max()))
+                    return executed;
+            }
+            executed += ExecBatch();
+        }
+    }
+
 private:
-    std::queue<std::function<void()>> tasks;
-    bool running{ true };
+
+    // waits for a task or an expired timer (returns false if stopped)
+    bool WaitReady(std::unique_lock<std::mutex>& lck)
+    {
+        runner = std::this_thread::get_id();
+        while (true)
+        {
+            if (!running)
+                return false;
+            if (!tasks.empty() || (!timers.Empty() && timers.NextExpiry() <= Clock::now()))
+                return true;
+            if (timers.Empty())
+                cv.wait(lck);
+            else
+                cv.wait_until(lck, timers.NextExpiry());
+        }
+    }
+
+    // takes the first expired timer or else the first task (mtx must be locked)
+    bool PopReady(std::function<void()>& task)
+    {
+        if (timers.PopExpired(Clock::now(), task))
+            return true;
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        notFull.notify_all();
+        return true;
+    }
+
+    // moves up to maxTasks expired timers and tasks in batch (mtx must be locked)
+    bool PopBatch(std::size_t maxTasks)
+    {
+        const auto now = Clock::now();
+        std::function<void()> task;
+        while (batch.size() < maxTasks && timers.PopExpired(now, task))
+            batch.push_back(std::move(task));
+        const std::size_t n = std::min(maxTasks - batch.size(), tasks.size());
+        if (batch.empty() && n == tasks.size())
+            batch.swap(tasks);
+        else
+        {
+            std::move(tasks.begin(), tasks.begin() + n, std::back_inserter(batch));
+            tasks.erase(tasks.begin(), tasks.begin() + n);
+        }
+        if (n > 0)
+            notFull.notify_all();
+        return !batch.empty();
+    }
+
+    // runs the tasks in batch (mtx must not be locked)
+    std::size_t ExecBatch()
+    {
+        std::size_t executed = 0;
+        try
+        {
+            for (; executed < batch.size() && running; ++executed)
+                if (batch[executed])
+                    batch[executed]();
+        }
+        catch (...)
+        {
+            Requeue(executed + 1);
+            throw;
+        }
+        Requeue(executed);
+        return executed;
+    }
+
+    // puts back at the front of the queue the tasks in batch from first on
+    void Requeue(std::size_t first)
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        if (first < batch.size())
+            tasks.insert(
+                tasks.begin(),
+                std::make_move_iterator(batch.begin() + static_cast<std::ptrdiff_t>(first)),
+                std::make_move_iterator(batch.end())
+            );
+        batch.clear();
+    }
+
+    std::deque<std::function<void()>> tasks;
+    std::deque<std::function<void()>> batch; // accessed only by the thread running the tasks
+    detail::TimerQueue timers;
+    std::size_t cancelledTimers = 0;
+    const std::size_t maxPending = 0; // 0 means unbounded
+    std::thread::id runner; // the last thread that ran the tasks
+    std::atomic<bool> running{ true };
     mutable std::mutex mtx;
     std::condition_variable cv;
+    std::condition_variable notFull;
 };
 
 } // namespace cli
@@ -30,24 +30,80 @@
 #ifndef CLI_SCHEDULER_H_
 #define CLI_SCHEDULER_H_
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <stdexcept>
 
 namespace cli
 {
 
+/**
+ * A `TimerHandle` refers to a task submitted with `Scheduler::PostAt` or
+ * `Scheduler::PostAfter`, and allows to cancel it.
+ */
+class TimerHandle
+{
+public:
+    // the state shared with the scheduler (for implementers of schedulers)
+    struct State
+    {
+        std::atomic<bool> cancelled{ false };
+        std::function<void()> onCancel; // set by the scheduler before returning the handle
+    };
+
+    TimerHandle() = default;
+    explicit TimerHandle(const std::shared_ptr<State>& _state) : state(_state) {}
+
+    /// Prevents the task from running, if it hasn't started yet.
+    /// It can be called from any thread, but only when it's called by the
+    /// thread running the scheduler the task is guaranteed not to run.
+    void Cancel() const
+    {
+        if (auto s = state.lock())
+        {
+            if (!s->cancelled.exchange(true) && s->onCancel)
+                s->onCancel();
+        }
+    }
+
+private:
+    // the scheduler releases the state when the task runs or is cancelled
+    std::weak_ptr<State> state;
+};
+
 /**
  * A `Scheduler` represents an engine capable of running a task.
  * Its method `Post` can be safely called from any thread to submit the task
  * that will execute in an unspecified thread of execution as soon as possible
  * (but in any case after the call to `Post` is terminated).
+ * The methods `PostAt` and `PostAfter` submit a task that will execute
+ * not before a given time (if the scheduler supports the timers).
  */
 class Scheduler
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     virtual ~Scheduler() = default;
 
     /// Submits a completion token or function object for execution.
     virtual void Post(const std::function<void()>& f) = 0;
+
+    /// Submits a function object for execution at time t.
+    /// The default implementation throws std::logic_error:
+    /// the schedulers supporting the timers override it.
+    virtual TimerHandle PostAt(Clock::time_point /*t*/, const std::function<void()>& /*f*/)
+    {
+        throw std::logic_error("timers not supported");
+    }
+
+    /// Submits a function object for execution after the duration d.
+    TimerHandle PostAfter(Clock::duration d, const std::function<void()>& f)
+    {
+        return PostAt(Clock::now() + d, f);
+    }
 };
 
 } // namespace cli
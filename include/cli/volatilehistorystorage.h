@@ -31,36 +31,48 @@
 #define CLI_VOLATILEHISTORYSTORAGE_H_
 
 #include "historystorage.h"
-#include <deque>
+#include "detail/ringbuffer.h"
+#include <memory>
 
 namespace cli
 {
 
+// Keeps the last size commands in memory.
+// Once full, the new commands reuse the strings of the oldest ones.
 class VolatileHistoryStorage : public HistoryStorage
 {
     public:
-        explicit VolatileHistoryStorage(std::size_t size = 1000) : maxSize(size) {}
+        explicit VolatileHistoryStorage(std::size_t size = 1000) : commands(size) {}
         void Store(const std::vector<std::string>& cmds) override
         {
-            using dt = std::deque<std::string>::difference_type;
-            commands.insert(commands.end(), cmds.begin(), cmds.end());
-            if (commands.size() > maxSize)
-                commands.erase(
-                    commands.begin(),
-                    commands.begin()+static_cast<dt>(commands.size()-maxSize)
-                );
+            for (const auto& c: cmds)
+                commands.PushBack(c); // when full, drops the oldest
+            snapshot.reset();
         }
         std::vector<std::string> Commands() const override
         {
-            return std::vector<std::string>(commands.begin(), commands.end());
+            std::vector<std::string> result;
+            result.reserve(commands.Size());
+            for (std::size_t i = 0; i < commands.Size(); ++i)
+                result.push_back(commands[i]);
+            return result;
+        }
+        // The same snapshot is returned until the next Store,
+        // so that all the sessions share it
+        std::shared_ptr<const HistorySnapshot> Snapshot() const override
+        {
+            if (!snapshot)
+                snapshot = std::make_shared<VectorHistorySnapshot>(Commands());
+            return snapshot;
         }
         void Clear() override
         {
-            commands.clear();
+            commands.Clear();
+            snapshot.reset();
         }
     private:
-        const std::size_t maxSize;
-        std::deque<std::string> commands;
+        detail::RingBuffer<std::string> commands; // commands[0] is the oldest
+        mutable std::shared_ptr<const HistorySnapshot> snapshot; // the last one returned
 };
 
 } // namespace cli
@@ -31,7 +31,10 @@
 #define SCHEDULER_TEST_TEMPLATES_H_
 
 #include <boost/test/unit_test.hpp>
+#include "cli/scheduler.h"
+#include <chrono>
 #include <thread>
+#include <vector>
 
 template <typename S>
 void SchedulingTest()
@@ -77,4 +80,116 @@ void ExceptionTest()
     BOOST_CHECK_THROW( scheduler.ExecOne(), int );
 }
 
+template <typename S>
+void MultiProducerTest()
+{
+    using namespace std;
+
+    S scheduler;
+    constexpr int producers = 4;
+    constexpr int tasksPerProducer = 10000;
+    vector<int> last(producers, -1);
+    bool ordered = true;
+    int executed = 0;
+
+    vector<thread> threads;
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back(
+            [&, p]()
+            {
+                for (int i = 0; i < tasksPerProducer; ++i)
+                    scheduler.Post( [&, p, i]()
+                    {
+                        // the tasks of the same producer run in order
+                        if (i != last[p] + 1) ordered = false;
+                        last[p] = i;
+                        ++executed;
+                    } );
+            }
+        );
+    while (executed < producers * tasksPerProducer)
+        scheduler.ExecOne();
+    for (auto& t: threads)
+        t.join();
+
+    BOOST_CHECK(ordered);
+    BOOST_CHECK_EQUAL(executed, producers * tasksPerProducer);
+    BOOST_CHECK(!scheduler.PollOne());
+}
+
+template <typename S>
+void StopTest()
+{
+    using namespace std;
+
+    S scheduler;
+    thread th( [&](){ scheduler.Run(); } );
+    scheduler.Post( [&](){ scheduler.Stop(); } );
+    th.join();
+    BOOST_CHECK(scheduler.Stopped());
+    BOOST_CHECK(!scheduler.ExecOne());
+}
+
+template <typename S>
+void TimerTest()
+{
+    using namespace std;
+    using namespace std::chrono;
+
+    S scheduler;
+    vector<int> order;
+    const auto start = steady_clock::now();
+    scheduler.PostAfter( milliseconds(30), [&](){ order.push_back(3); } );
+    scheduler.PostAt( start + milliseconds(10), [&](){ order.push_back(1); } );
+    scheduler.PostAfter( milliseconds(20), [&](){ order.push_back(2); } );
+    scheduler.Post( [&](){ order.push_back(0); } );
+    while (order.size() < 4)
+        scheduler.ExecOne();
+
+    BOOST_CHECK(steady_clock::now() - start >= milliseconds(30));
+    const vector<int> expected = {0, 1, 2, 3};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+template <typename S>
+void TimerCancelTest()
+{
+    using namespace std;
+    using namespace std::chrono;
+
+    S scheduler;
+    vector<int> order;
+    const auto start = steady_clock::now();
+    // the last timer to expire: the cancelled ones expire before it
+    scheduler.PostAt( start + milliseconds(10), [&](){ order.push_back(2); } );
+    // cancelled from another thread
+    auto cancelled = scheduler.PostAt( start, [&](){ order.push_back(1); } );
+    thread th( [&](){ cancelled.Cancel(); } );
+    th.join();
+    // many timers cancelled
+    vector<cli::TimerHandle> handles;
+    for (int i = 0; i < 1000; ++i)
+        handles.push_back(scheduler.PostAt( start, [&](){ order.push_back(4); } ));
+    for (auto& h: handles)
+        h.Cancel();
+    // cancelled from the running thread by another task
+    cli::TimerHandle cancelledByTask;
+    scheduler.Post( [&]()
+    {
+        cancelledByTask = scheduler.PostAt( start, [&](){ order.push_back(3); } );
+        cancelledByTask.Cancel();
+    } );
+    // cancelling an empty handle does nothing
+    cli::TimerHandle().Cancel();
+
+    // No timer can run before this loop, so all of them are cancelled before
+    // their expiry whatever the time elapsed: when the last timer runs,
+    // the others would have already run, if they were not cancelled.
+    while (order.empty())
+        scheduler.ExecOne();
+
+    BOOST_CHECK_EQUAL(order.size(), 1u);
+    BOOST_CHECK_EQUAL(order.front(), 2);
+}
+
 #endif // SCHEDULER_TEST_TEMPLATES_H_
@@ -50,6 +50,16 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     ExceptionTest<BoostAsioScheduler>();
 }
 
+BOOST_AUTO_TEST_CASE(Timers)
+{
+    TimerTest<BoostAsioScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(TimersCancel)
+{
+    TimerCancelTest<BoostAsioScheduler>();
+}
+
 BOOST_AUTO_TEST_CASE(BoostAsioNonOwner)
 {
     detail::BoostAsioLib::ContextType ioc;
@@ -30,6 +30,11 @@
 #include <boost/test/unit_test.hpp>
 #include "cli/cli.h"
 #include "cli/clifilesession.h"
+#include "cli/loopscheduler.h"
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 using namespace cli;
@@ -87,6 +92,62 @@ void UserInput(Cli& cli, stringstream& oss, const string& input)
     session.Start();
 }
 
+// a command written for the interface taking a vector of strings
+class LegacyCommand : public Command
+{
+public:
+    LegacyCommand() : Command("legacy") {}
+    bool Exec(const vector<string>& cmdLine, CliSession& session) override
+    {
+        if (cmdLine.empty() || cmdLine[0] != Name()) return false;
+        session.OutStream() << "legacy";
+        for (auto i = next(cmdLine.begin()); i != cmdLine.end(); ++i)
+            session.OutStream() << ' ' << *i;
+        session.OutStream() << '\n';
+        return true;
+    }
+    void Help(ostream& out) const override { out << " - " << Name() << '\n'; }
+};
+
+// a command using the token view
+class ViewCommand : public Command
+{
+public:
+    ViewCommand() : Command("view") {}
+    using Command::Exec;
+    bool Exec(CmdLineView cmdLine, CliSession& session) override
+    {
+        if (cmdLine.empty() || cmdLine[0] != Name()) return false;
+        session.OutStream() << "view " << cmdLine.size() - 1 << '\n';
+        return true;
+    }
+    void Help(ostream& out) const override { out << " - " << Name() << '\n'; }
+};
+
+// a command handling also the lines starting with its alias
+class AliasCommand : public Command
+{
+public:
+    AliasCommand() : Command("long") {}
+    using Command::Exec;
+    bool Exec(CmdLineView cmdLine, CliSession& session) override
+    {
+        if (cmdLine.empty() || (cmdLine[0] != Name() && cmdLine[0] != "l")) return false;
+        session.OutStream() << "long\n";
+        return true;
+    }
+    bool DispatchByName() const override { return false; }
+    void Help(ostream& out) const override { out << " - " << Name() << '\n'; }
+};
+
+// a command overriding no Exec overload
+class NoExecCommand : public Command
+{
+public:
+    NoExecCommand() : Command("noexec") {}
+    void Help(ostream& out) const override { out << " - " << Name() << '\n'; }
+};
+
 } // namespace
 
 BOOST_AUTO_TEST_SUITE(CliSuite)
@@ -209,6 +270,14 @@ BOOST_AUTO_TEST_CASE(parameters)
     BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
     UserInput(cli, oss, "int_cmd 99999999999999999999999999999999999999999");
     BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+    UserInput(cli, oss, "int_cmd +42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "42");
+    UserInput(cli, oss, "int_cmd +-42");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+    UserInput(cli, oss, "int_cmd -2147483648");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "-2147483648");
+    UserInput(cli, oss, "int_cmd 42a");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
 
     UserInput(cli, oss, "unsigned_int_cmd 42");
     BOOST_CHECK_EQUAL(ExtractContent(oss), "42");
@@ -256,6 +325,10 @@ BOOST_AUTO_TEST_CASE(parameters)
     BOOST_CHECK_EQUAL(ExtractContent(oss), "0.1");
     UserInput(cli, oss, "double_cmd a");
     BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+    UserInput(cli, oss, "double_cmd 1e99999");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+    UserInput(cli, oss, "double_cmd 0.1x");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
 
     UserInput(cli, oss, "long_double_cmd 0.1");
     BOOST_CHECK_EQUAL(ExtractContent(oss), "0.1");
@@ -370,6 +443,141 @@ BOOST_AUTO_TEST_CASE(Submenus)
     BOOST_CHECK_EQUAL(ExtractContent(oss), "foo");
 }
 
+BOOST_AUTO_TEST_CASE(Overloads)
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    for (int i = 0; i < 100; ++i)
+        rootMenu->Insert("cmd" + to_string(i), [i](ostream& out){ out << i << "\n"; } );
+    rootMenu->Insert("over", [](ostream& out){ out << "none\n"; } );
+    rootMenu->Insert("over", [](ostream& out, int par){ out << "int " << par << "\n"; } );
+    rootMenu->Insert("over", [](ostream& out, const string& par){ out << "string " << par << "\n"; } );
+    rootMenu->Insert("over", [](ostream& out, int par1, int par2){ out << "int int " << par1 << par2 << "\n"; } );
+    auto subMenu = make_unique<Menu>("over");
+    subMenu->Insert("foo", [](ostream& out){ out << "sub foo\n"; } );
+    rootMenu->Insert(std::move(subMenu));
+
+    Cli cli(std::move(rootMenu));
+
+    stringstream oss;
+
+    UserInput(cli, oss, "cmd42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "42");
+
+    UserInput(cli, oss, "over");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "none");
+
+    UserInput(cli, oss, "over 42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "int 42");
+
+    UserInput(cli, oss, "over bar");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "string bar");
+
+    UserInput(cli, oss, "over 4 2");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "int int 42");
+
+    UserInput(cli, oss, "over 4 x");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+
+    // the function with a string parameter is inserted before the submenu
+    UserInput(cli, oss, "over foo");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "string foo");
+
+    UserInput(cli, oss, "over foo bar");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(RemoveCommands)
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    auto intCmd = rootMenu->Insert("cmd", [](ostream& out, int par){ out << "int " << par << "\n"; } );
+    auto stringCmd = rootMenu->Insert("cmd", [](ostream& out, const string& par){ out << "string " << par << "\n"; } );
+    auto otherCmd = rootMenu->Insert("other", [](ostream& out){ out << "other\n"; } );
+
+    Cli cli(std::move(rootMenu));
+
+    stringstream oss;
+
+    UserInput(cli, oss, "cmd 42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "int 42");
+
+    intCmd.Remove();
+    UserInput(cli, oss, "cmd 42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "string 42");
+
+    stringCmd.Disable();
+    UserInput(cli, oss, "cmd 42");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+
+    stringCmd.Enable();
+    UserInput(cli, oss, "cmd 42");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "string 42");
+
+    stringCmd.Remove();
+    UserInput(cli, oss, "cmd 42");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+
+    // removing twice has no effect
+    stringCmd.Remove();
+    UserInput(cli, oss, "other");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "other");
+
+    otherCmd.Remove();
+    UserInput(cli, oss, "other");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(CustomCommands)
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    auto subMenu = make_unique<Menu>("sub");
+    auto subSubMenu = make_unique<Menu>("subsub");
+    subSubMenu->Insert(make_unique<LegacyCommand>());
+    subSubMenu->Insert(make_unique<ViewCommand>());
+    subSubMenu->Insert(make_unique<AliasCommand>());
+    subMenu->Insert(std::move(subSubMenu));
+    rootMenu->Insert(std::move(subMenu));
+
+    Cli cli(std::move(rootMenu));
+
+    stringstream oss;
+
+    UserInput(cli, oss, "sub subsub legacy foo bar");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "legacy foo bar");
+
+    UserInput(cli, oss, "sub subsub view foo bar");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "view 2");
+
+    UserInput(cli, oss, "sub\nsubsub\nlegacy");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "legacy");
+
+    // a command not dispatched by name gets the other lines, too
+    UserInput(cli, oss, "sub subsub long");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "long");
+    UserInput(cli, oss, "sub subsub l");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "long");
+
+    // both interfaces can be called on any command
+    LegacyCommand legacy;
+    Command& legacyCmd = legacy;
+    CliFileSession session(cli, cin, oss);
+    oss.str("");
+    const vector<string> line = { "legacy", "42" };
+    BOOST_CHECK(legacyCmd.Exec(CmdLineView(line), session));
+    BOOST_CHECK_EQUAL(oss.str(), "legacy 42\n");
+
+    ViewCommand view;
+    oss.str("");
+    BOOST_CHECK(view.Exec(vector<string>{ "view", "4", "2" }, session));
+    BOOST_CHECK_EQUAL(oss.str(), "view 2\n");
+
+    // a command overriding neither overload throws instead of recursing
+    NoExecCommand noExec;
+    Command& noExecCmd = noExec;
+    const vector<string> noExecLine = { "noexec" };
+    BOOST_CHECK_THROW(noExecCmd.Exec(CmdLineView(noExecLine), session), std::logic_error);
+    BOOST_CHECK_THROW(noExecCmd.Exec(noExecLine, session), std::logic_error);
+}
+
 BOOST_AUTO_TEST_CASE(EnterActions)
 {
     auto rootMenu = make_unique<Menu>("cli");
@@ -414,6 +622,7 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     auto rootMenu = make_unique<Menu>("cli");
     rootMenu->Insert("stdexception", [](ostream&){ throw std::logic_error("myerror"); } );
     rootMenu->Insert("customexception", [](ostream&){ throw 42; } );
+    rootMenu->Insert("badcast", [](ostream&, int){ throw std::bad_cast(); } );
 
     Cli cli(std::move(rootMenu));
 
@@ -423,6 +632,10 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     BOOST_CHECK_NO_THROW( UserInput(cli, oss, "stdexception") );
     BOOST_CHECK_EQUAL(ExtractContent(oss), "myerror");
 
+    // a std::bad_cast thrown by the handler is not taken as a parameter mismatch
+    BOOST_CHECK_NO_THROW( UserInput(cli, oss, "badcast 42") );
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") == string::npos);
+
     // std exception type, custom handler
     bool excActionDone = false;
     cli.StdExceptionHandler( [&](std::ostream&, const std::string&, const std::exception&) noexcept { excActionDone = true; } );
@@ -433,4 +646,281 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     BOOST_CHECK_NO_THROW( UserInput(cli, oss, "customexception") );
 }
 
+BOOST_AUTO_TEST_CASE(Stats)
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("foo", [](ostream& out, int x){ out << x; } );
+    rootMenu->Insert("error", [](ostream&){ throw std::logic_error("myerror"); } );
+    auto subMenu = make_unique<Menu>("sub");
+    subMenu->Insert("bar", [](ostream&){ throw 42; } );
+    subMenu->Insert("baz", [](ostream&){} );
+    rootMenu->Insert(std::move(subMenu));
+
+    Cli cli(std::move(rootMenu));
+
+    stringstream oss;
+
+    // disabled by default
+    UserInput(cli, oss, "foo 1");
+    BOOST_CHECK(cli.GetStats().commands.empty());
+    UserInput(cli, oss, "stats");
+    BOOST_CHECK(ExtractContent(oss).find("wrong command:") != string::npos);
+
+    cli.EnableStats();
+
+    oss.str("");
+    oss.clear();
+    stringstream iss;
+    iss.str("foo 1\nfoo 2\nfoo x\nerror\nsub bar\nsub baz\nsub\nbaz\nunknown\n");
+    {
+        CliFileSession session(cli, iss, oss);
+        session.Start();
+
+        // the running sessions are collected too
+        auto stats = cli.GetStats();
+        BOOST_CHECK_EQUAL(stats.commands.size(), 5u);
+    }
+
+    auto stats = cli.GetStats();
+    BOOST_REQUIRE_EQUAL(stats.commands.size(), 5u);
+    // sorted by command
+    BOOST_CHECK_EQUAL(stats.commands[0].command, "error");
+    BOOST_CHECK_EQUAL(stats.commands[0].count, 1u);
+    BOOST_CHECK_EQUAL(stats.commands[0].errors, 1u);
+    BOOST_CHECK_EQUAL(stats.commands[1].command, "foo");
+    BOOST_CHECK_EQUAL(stats.commands[1].count, 2u);
+    BOOST_CHECK_EQUAL(stats.commands[1].errors, 0u);
+    BOOST_CHECK_EQUAL(stats.commands[1].latency.Count(), 2u);
+    BOOST_CHECK_EQUAL(stats.commands[2].command, "sub");
+    BOOST_CHECK_EQUAL(stats.commands[2].count, 1u);
+    BOOST_CHECK_EQUAL(stats.commands[3].command, "sub bar");
+    BOOST_CHECK_EQUAL(stats.commands[3].errors, 1u);
+    BOOST_CHECK_EQUAL(stats.commands[4].command, "sub baz");
+    BOOST_CHECK_EQUAL(stats.commands[4].count, 2u); // from the root and from the submenu
+    BOOST_CHECK_EQUAL(stats.wrongCommands, 2u); // "foo x" and "unknown"
+
+    // the stats of the ended sessions are kept
+    UserInput(cli, oss, "stats");
+    const auto content = ExtractContent(oss);
+    BOOST_CHECK(content.find("command") != string::npos);
+    BOOST_CHECK(content.find("sub baz") != string::npos);
+    BOOST_CHECK(content.find("wrong commands: 2") != string::npos);
+    BOOST_CHECK_EQUAL(cli.GetStats().commands.size(), 6u); // "stats"
+}
+
+BOOST_AUTO_TEST_CASE(AsyncCommands)
+{
+    std::thread worker;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("now", [](ostream& out, Completion done){ out << "started\n"; done([](ostream& o){ o << "done\n"; }); } );
+    rootMenu->Insert("later", [&](ostream&, Completion done, int x)
+    {
+        worker = std::thread([done, x](){ done([x](ostream& o){ o << "result " << x << '\n'; }); });
+    } );
+    rootMenu->Insert("future", [](ostream&, int x){ return std::async(std::launch::async, [x](){ return x * 2; }); } );
+    rootMenu->Insert("futurevoid", [](ostream&){ return std::async(std::launch::async, [](){}); } );
+    rootMenu->Insert("futureerror", [](ostream&){ return std::async(std::launch::async, []() -> int { throw std::logic_error("myerror"); }); } );
+    rootMenu->Insert("twice", [](ostream&, Completion done){ done([](ostream& o){ o << "first\n"; }); done([](ostream& o){ o << "second\n"; }); } );
+
+    Cli cli(std::move(rootMenu));
+    cli.EnableStats();
+
+    stringstream oss;
+
+    // without a scheduler, the session waits for the completion
+
+    UserInput(cli, oss, "now");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "started\ndone");
+
+    UserInput(cli, oss, "later 42");
+    worker.join();
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "result 42");
+
+    UserInput(cli, oss, "future 21");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "42");
+
+    UserInput(cli, oss, "futurevoid");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "");
+
+    UserInput(cli, oss, "futureerror");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "myerror");
+
+    UserInput(cli, oss, "twice");
+    BOOST_CHECK_EQUAL(ExtractContent(oss), "first");
+
+    // with a scheduler, the session is resumed by the scheduler
+
+    LoopScheduler scheduler;
+    oss.str("");
+    {
+        CliSession session(cli, oss);
+        session.UseScheduler(scheduler);
+
+        session.Feed("later 7");
+        BOOST_CHECK(session.Busy());
+        session.Prompt(); // suppressed
+        BOOST_CHECK_EQUAL(oss.str(), "");
+        worker.join();
+        while (scheduler.PollOne()) {}
+        BOOST_CHECK(!session.Busy());
+        BOOST_CHECK_EQUAL(oss.str(), "result 7\ncli> ");
+
+        oss.str("");
+        session.Feed("future 5");
+        while (session.Busy())
+            scheduler.ExecOne();
+        BOOST_CHECK_EQUAL(oss.str(), "10\ncli> ");
+
+        // an asynchronous command replayed from the history reports its own line
+        cli.StdExceptionHandler([](ostream& o, const string& cmd, const std::exception&){ o << "error in " << cmd << '\n'; });
+        session.Feed("futureerror");
+        while (session.Busy())
+            scheduler.ExecOne();
+        oss.str("");
+        session.Feed("history");
+        const auto historyOut = oss.str();
+        const auto id = historyOut.rfind('\n', historyOut.find("\tfutureerror"));
+        BOOST_REQUIRE(id != string::npos);
+        oss.str("");
+        session.Feed("! " + historyOut.substr(id + 1, historyOut.find('\t', id) - id - 1));
+        while (session.Busy())
+            scheduler.ExecOne();
+        BOOST_CHECK_EQUAL(oss.str(), "error in futureerror\ncli> ");
+
+        // a session gone before the completion
+        {
+            CliSession other(cli, oss);
+            other.UseScheduler(scheduler);
+            other.Feed("later 1");
+            BOOST_CHECK(other.Busy());
+        }
+        oss.str("");
+        worker.join();
+        while (scheduler.PollOne()) {}
+        BOOST_CHECK_EQUAL(oss.str(), "");
+    }
+
+    // the latency is measured until the completion
+    const auto stats = cli.GetStats();
+    auto later = std::find_if(stats.commands.begin(), stats.commands.end(), [](const CommandStats& s){ return s.command == "later"; });
+    BOOST_REQUIRE(later != stats.commands.end());
+    BOOST_CHECK_EQUAL(later->count, 2u); // the one of the session gone is not recorded
+    auto futureError = std::find_if(stats.commands.begin(), stats.commands.end(), [](const CommandStats& s){ return s.command == "futureerror"; });
+    BOOST_REQUIRE(futureError != stats.commands.end());
+    BOOST_CHECK_EQUAL(futureError->errors, 3u); // with the one replayed from the history
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerWithoutTimers)
+{
+    // a scheduler written before the timers were added
+    class OldScheduler : public Scheduler
+    {
+    public:
+        void Post(const std::function<void()>& f) override { tasks.push_back(f); }
+        std::vector<std::function<void()>> tasks;
+    };
+    OldScheduler scheduler;
+    BOOST_CHECK_THROW(scheduler.PostAfter(std::chrono::seconds(1), [](){}), std::logic_error);
+
+    // the commands waiting for a future fail
+    std::promise<int> promise;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("future", [&](ostream&){ return promise.get_future(); } );
+    Cli cli(std::move(rootMenu));
+    stringstream oss;
+    {
+        CliSession session(cli, oss);
+        session.UseScheduler(scheduler);
+        session.Feed("future");
+        BOOST_CHECK(oss.str().find("timers not supported") != string::npos);
+        BOOST_CHECK(!session.Busy());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Cancellation)
+{
+    CancellationToken never;
+    BOOST_CHECK(!never.IsCancelled());
+    never.OnCancel([](){ BOOST_ERROR("never cancelled"); });
+
+    std::atomic<int> loops{ 0 };
+    std::atomic<int> ended{ 0 };
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("loop", [&](ostream&, CancellationToken token)
+    {
+        return std::async(std::launch::async, [&loops, &ended, token]()
+        {
+            while (!token.IsCancelled())
+            {
+                ++loops;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            ++ended;
+        });
+    } );
+    Cli cli(std::move(rootMenu));
+
+    LoopScheduler scheduler;
+    stringstream oss;
+    {
+        CliSession session(cli, oss);
+        session.UseScheduler(scheduler);
+
+        BOOST_CHECK(!session.Interrupt()); // nothing to interrupt
+
+        session.Feed("loop");
+        while (loops == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        oss.str("");
+        BOOST_CHECK(session.Interrupt());
+        BOOST_CHECK(!session.Busy());
+        BOOST_CHECK_EQUAL(oss.str(), "cli> ");
+
+        // the token is cancelled when the session ends, too
+        session.Feed("loop");
+        BOOST_CHECK(session.Busy());
+    }
+    // the loops end (the scheduler has left the futures of the cancelled commands to other threads)
+    while (ended < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (std::chrono::steady_clock::now() < end)
+        if (!scheduler.PollOne())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+BOOST_AUTO_TEST_CASE(CancelledFuture, * boost::unit_test::timeout(60))
+{
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<bool> ended{ false };
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("wait", [&](ostream&)
+    {
+        return std::async(std::launch::async, [&ended, released](){ released.wait(); ended = true; });
+    } );
+    Cli cli(std::move(rootMenu));
+
+    LoopScheduler scheduler;
+    stringstream oss;
+    CliSession session(cli, oss);
+    session.UseScheduler(scheduler);
+
+    session.Feed("wait");
+    BOOST_CHECK(session.Busy());
+    BOOST_CHECK(session.Interrupt());
+
+    // the scheduler stops polling the future of the cancelled command,
+    // without waiting for the task in its destructor
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    while (scheduler.PollOne()) {}
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    BOOST_CHECK(!scheduler.PollOne());
+    BOOST_CHECK(!ended);
+
+    release.set_value();
+    while (!ended)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,318 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <future>
+#include <sstream>
+#include "cli/cli.h"
+#include "cli/loopscheduler.h"
+#include "cli/detail/commandprocessor.h"
+#include "cli/detail/telnetscreen.h"
+
+using namespace std;
+using namespace cli;
+using namespace cli::detail;
+
+namespace
+{
+
+class FakeInputDevice : public InputDevice
+{
+public:
+    explicit FakeInputDevice(Scheduler& _scheduler) : InputDevice(_scheduler) {}
+    void Key(KeyType k, char c = ' ') { Notify(std::make_pair(k, c)); }
+    void Text(const string& text) { Notify(text.data(), text.size()); }
+};
+
+// a session processing the input of a device, as the telnet and local ones
+class DeviceSession : public CliSession
+{
+public:
+    DeviceSession(Cli& _cli, Scheduler& scheduler, InputDevice& device, ostream& _out) :
+        CliSession(_cli, _out),
+        processor(*this, device)
+    {
+        UseScheduler(scheduler);
+    }
+protected:
+    void OnCommandCompleted() override
+    {
+        CliSession::OnCommandCompleted();
+        processor.Resume();
+    }
+private:
+    CommandProcessor<TelnetScreen> processor;
+};
+
+void Process(LoopScheduler& scheduler)
+{
+    while (scheduler.PollOne()) {}
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CommandProcessorSuite)
+
+BOOST_AUTO_TEST_CASE(TextRuns)
+{
+    string lastCmd;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("cmd", [&](ostream&, const string& par1, const string& par2){ lastCmd = par1 + " " + par2; } );
+    Cli cli(std::move(rootMenu));
+
+    LoopScheduler scheduler;
+    FakeInputDevice device(scheduler);
+    stringstream oss;
+    CliSession session(cli, oss);
+    CommandProcessor<TelnetScreen> processor(session, device);
+
+    device.Text("cmd foar");
+    device.Key(KeyType::left);
+    device.Key(KeyType::left);
+    device.Text("o b");
+    device.Key(KeyType::end);
+    device.Key(KeyType::ascii, 'z');
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "foo barz");
+
+    oss.str("");
+    device.Text("cmd bar");
+    Process(scheduler);
+    // the whole text is printed at once
+    BOOST_CHECK_EQUAL(oss.str(), "cmd bar");
+}
+
+BOOST_AUTO_TEST_CASE(TextFallback)
+{
+    LoopScheduler scheduler;
+    FakeInputDevice device(scheduler);
+    string keys;
+    device.Register([&](std::pair<KeyType, char> k){ if (k.first == KeyType::ascii) keys += k.second; });
+
+    device.Text("foo bar");
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(keys, "foo bar");
+}
+
+BOOST_AUTO_TEST_CASE(ReverseSearch)
+{
+    string lastCmd;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("cmd", [&](ostream&, const string& par){ lastCmd = par; } );
+    auto storage = make_unique<VolatileHistoryStorage>();
+    storage->Store({ "cmd alpha", "cmd beta", "cmd alphabet" });
+    Cli cli(std::move(rootMenu), std::move(storage));
+
+    LoopScheduler scheduler;
+    FakeInputDevice device(scheduler);
+    stringstream oss;
+    CliSession session(cli, oss);
+    CommandProcessor<TelnetScreen> processor(session, device);
+
+    // the newest match
+    device.Key(KeyType::search);
+    device.Text("alp");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "alphabet");
+
+    // the next match (skipping the same command just executed)
+    device.Key(KeyType::search);
+    device.Text("alpha");
+    device.Key(KeyType::search);
+    device.Key(KeyType::search);
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "alpha");
+
+    // backspace restarts from the newest
+    device.Key(KeyType::search);
+    device.Key(KeyType::ascii, 'b');
+    device.Key(KeyType::ascii, 'x');
+    device.Key(KeyType::backspace);
+    device.Key(KeyType::ascii, 'e');
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "alphabet");
+
+    // other keys accept the match, that can be edited
+    device.Key(KeyType::search);
+    device.Text("beta");
+    device.Key(KeyType::end);
+    device.Key(KeyType::ascii, 'z');
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "betaz");
+
+    // nothing found: the line is unchanged
+    device.Text("cmd x");
+    device.Key(KeyType::search);
+    device.Text("nothing");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "x");
+}
+
+BOOST_AUTO_TEST_CASE(AsyncCommand)
+{
+    Completion pending{ nullptr };
+    string lastCmd;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("slow", [&](ostream&, Completion done){ pending = done; } );
+    rootMenu->Insert("cmd", [&](ostream&, const string& par){ lastCmd = par; } );
+    Cli cli(std::move(rootMenu));
+
+    LoopScheduler scheduler;
+    FakeInputDevice device(scheduler);
+    stringstream oss;
+    DeviceSession session(cli, scheduler, device, oss);
+
+    device.Text("slow");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK(session.Busy());
+
+    // the input is queued, and the prompt is not shown
+    oss.str("");
+    device.Text("cmd foo");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(oss.str(), "");
+    BOOST_CHECK_EQUAL(lastCmd, "");
+
+    // the prompt is back on completion, followed by the input queued
+    pending([](ostream& out){ out << "finished\n"; });
+    Process(scheduler);
+    BOOST_CHECK(!session.Busy());
+    BOOST_CHECK_EQUAL(oss.str().substr(0, 14), "finished\ncli> ");
+    BOOST_CHECK_EQUAL(lastCmd, "foo");
+
+    device.Text("cmd bar");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "bar");
+
+    // a command queued can be asynchronous, too: the rest waits for it
+    device.Text("slow");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    device.Text("slow");
+    device.Key(KeyType::ret);
+    device.Text("cmd baz");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    pending([](ostream&){});
+    Process(scheduler);
+    BOOST_CHECK(session.Busy());
+    BOOST_CHECK_EQUAL(lastCmd, "bar");
+    pending([](ostream&){});
+    Process(scheduler);
+    BOOST_CHECK(!session.Busy());
+    BOOST_CHECK_EQUAL(lastCmd, "baz");
+}
+
+BOOST_AUTO_TEST_CASE(Interrupt)
+{
+    Completion pending{ nullptr };
+    bool cancelled = false;
+    string lastCmd;
+    std::promise<int> result;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("slow", [&](ostream&, Completion done)
+    {
+        pending = done;
+        done.Token().OnCancel([&](){ cancelled = true; });
+    } );
+    rootMenu->Insert("wait", [&](ostream&, CancellationToken token)
+    {
+        token.OnCancel([&](){ result.set_value(0); });
+        return result.get_future();
+    } );
+    rootMenu->Insert("cmd", [&](ostream&, const string& par){ lastCmd = par; } );
+    Cli cli(std::move(rootMenu));
+    cli.EnableStats();
+
+    LoopScheduler scheduler;
+    FakeInputDevice device(scheduler);
+    stringstream oss;
+    DeviceSession session(cli, scheduler, device, oss);
+
+    // when idle, the line is discarded
+    device.Text("cmd foo");
+    device.Key(KeyType::interrupt);
+    Process(scheduler);
+    oss.str("");
+    device.Text("cmd bar");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(lastCmd, "bar");
+
+    // the running command is cancelled, with the input queued, and the prompt is back
+    device.Text("slow");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK(session.Busy());
+    device.Text("cmd baz");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    oss.str("");
+    device.Key(KeyType::interrupt);
+    Process(scheduler);
+    BOOST_CHECK(cancelled);
+    BOOST_CHECK(!session.Busy());
+    BOOST_CHECK_EQUAL(oss.str(), "^C\r\ncli> ");
+    BOOST_CHECK(pending.Token().IsCancelled());
+    BOOST_CHECK_EQUAL(lastCmd, "bar");
+
+    // its completion is ignored
+    oss.str("");
+    pending([](ostream& out){ out << "late\n"; });
+    Process(scheduler);
+    BOOST_CHECK_EQUAL(oss.str(), "");
+
+    // a handler returning a future gets the token, too
+    device.Text("wait");
+    device.Key(KeyType::ret);
+    Process(scheduler);
+    BOOST_CHECK(session.Busy());
+    device.Key(KeyType::interrupt);
+    Process(scheduler);
+    BOOST_CHECK(!session.Busy());
+
+    // the interrupted commands are errors
+    const auto stats = cli.GetStats();
+    auto slow = std::find_if(stats.commands.begin(), stats.commands.end(), [](const CommandStats& s){ return s.command == "slow"; });
+    BOOST_REQUIRE(slow != stats.commands.end());
+    BOOST_CHECK_EQUAL(slow->errors, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include "cli/detail/statsregistry.h"
+
+using namespace cli;
+using namespace cli::detail;
+
+BOOST_AUTO_TEST_SUITE(CommandStatsSuite)
+
+BOOST_AUTO_TEST_CASE(HistogramBuckets)
+{
+    // exact under 8
+    for (std::uint64_t v = 0; v < 8; ++v)
+    {
+        BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(v), v);
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketHigh(v), v);
+    }
+    // then 8 buckets for each power of two
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(8), 8u);
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(15), 15u);
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(16), 16u);
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(17), 16u);
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(18), 17u);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketHigh(16), 17u);
+    // the values are in their bucket, with an error less than 12.5%
+    for (std::uint64_t v = 1; v < (std::uint64_t(1) << 32); v = v * 3 + 1)
+    {
+        const auto b = LatencyHistogram::Bucket(v);
+        BOOST_REQUIRE(b < LatencyHistogram::Buckets);
+        const auto high = LatencyHistogram::BucketHigh(b);
+        BOOST_CHECK_GE(high, v);
+        BOOST_CHECK_LE(static_cast<double>(high - v), static_cast<double>(v) / 8);
+        BOOST_CHECK(b == 0 || LatencyHistogram::BucketHigh(b-1) < v);
+    }
+    // the biggest values are in the last bucket
+    BOOST_CHECK_EQUAL(LatencyHistogram::Bucket(std::uint64_t(1) << 40), LatencyHistogram::Buckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(HistogramPercentiles)
+{
+    LatencyHistogram h;
+    BOOST_CHECK_EQUAL(h.Percentile(0.5), 0u);
+
+    for (std::uint64_t v = 1; v <= 1000; ++v)
+        h.Record(v);
+    BOOST_CHECK_EQUAL(h.Count(), 1000u);
+    BOOST_CHECK_EQUAL(h.Max(), 1000u);
+    const auto p50 = h.Percentile(0.5);
+    BOOST_CHECK(p50 >= 500 && p50 <= 500 + 500/8);
+    const auto p99 = h.Percentile(0.99);
+    BOOST_CHECK(p99 >= 990 && p99 <= 1000);
+    BOOST_CHECK_EQUAL(h.Percentile(1), 1000u);
+
+    LatencyHistogram other;
+    other.Record(5000);
+    h.Merge(other);
+    BOOST_CHECK_EQUAL(h.Count(), 1001u);
+    BOOST_CHECK_EQUAL(h.Max(), 5000u);
+    BOOST_CHECK_EQUAL(h.Percentile(1), 5000u);
+}
+
+BOOST_AUTO_TEST_CASE(Registry)
+{
+    StatsRegistry registry;
+    auto s1 = registry.NewShard();
+    auto s2 = registry.NewShard();
+
+    s1->Record("foo", 10, false);
+    s1->Record("foo", 20, true);
+    s2->Record("foo", 30, false);
+    s2->Record("bar", 40, false);
+    s2->WrongCommand();
+
+    auto stats = registry.Collect();
+    BOOST_REQUIRE_EQUAL(stats.commands.size(), 2u);
+    BOOST_CHECK_EQUAL(stats.commands[0].command, "bar");
+    BOOST_CHECK_EQUAL(stats.commands[1].command, "foo");
+    BOOST_CHECK_EQUAL(stats.commands[1].count, 3u);
+    BOOST_CHECK_EQUAL(stats.commands[1].errors, 1u);
+    BOOST_CHECK_EQUAL(stats.commands[1].latency.Max(), 30u);
+    BOOST_CHECK_EQUAL(stats.wrongCommands, 1u);
+
+    // the stats of a retired shard are kept
+    registry.Retire(s2);
+    s2.reset();
+    stats = registry.Collect();
+    BOOST_CHECK_EQUAL(stats.commands[1].count, 3u);
+    BOOST_CHECK_EQUAL(stats.wrongCommands, 1u);
+    s1->Record("foo", 10, false);
+    BOOST_CHECK_EQUAL(registry.Collect().commands[1].count, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentCollect)
+{
+    StatsRegistry registry;
+    auto shard = registry.NewShard();
+    const std::uint64_t n = 20000;
+
+    std::thread writer([&]()
+    {
+        for (std::uint64_t i = 0; i < n; ++i)
+            shard->Record("cmd" + std::to_string(i % 50), i % 100, false);
+    });
+    std::uint64_t last = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        std::uint64_t count = 0;
+        for (const auto& c: registry.Collect().commands)
+            count += c.count;
+        BOOST_CHECK_GE(count, last); // never goes back
+        last = count;
+    }
+    writer.join();
+
+    std::uint64_t count = 0;
+    for (const auto& c: registry.Collect().commands)
+        count += c.count;
+    BOOST_CHECK_EQUAL(count, n);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -29,10 +29,39 @@
 
 #include <boost/test/unit_test.hpp>
 #include "cli/filehistorystorage.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#if !defined(CLI_OS_WIN)
+    #include <sys/stat.h> // mkdir
+    #include <unistd.h> // rmdir
+#endif
 
 using namespace cli;
 
-BOOST_AUTO_TEST_SUITE(FileHistoryStorageSuite)
+namespace
+{
+std::string FileContent(const std::string& name)
+{
+    std::ifstream f(name, std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+// removes the files written by the test case
+struct RemoveHistoryFiles
+{
+    ~RemoveHistoryFiles()
+    {
+        for (const char* suffix: { "", ".tmp", ".lock" })
+            std::remove((std::string("cli_test_history") + suffix).c_str());
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(FileHistoryStorageSuite, RemoveHistoryFiles)
 
 BOOST_AUTO_TEST_CASE(Basics)
 {
@@ -83,4 +112,183 @@ BOOST_AUTO_TEST_CASE(Persistence)
     BOOST_CHECK(s2.Commands().empty()); // check clear
 }
 
+BOOST_AUTO_TEST_CASE(SpecialCommands)
+{
+    FileHistoryStorage s("cli_test_history", 10);
+    s.Clear();
+
+    // commands that look like records
+    const std::vector<std::string> v = { "", "3:abc", "12", ":", "a b  c" };
+    s.Store(v);
+    auto result = s.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(v.begin(), v.end(), result.begin(), result.end());
+    s.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedRecord)
+{
+    FileHistoryStorage s("cli_test_history", 10);
+    s.Clear();
+    s.Store({ "item1", "item2" });
+    {
+        // a write interrupted by a crash
+        std::ofstream f("cli_test_history", std::ios_base::app | std::ios_base::binary);
+        f << "5:ite";
+    }
+    BOOST_CHECK_EQUAL(s.Commands().size(), 2u);
+
+    FileHistoryStorage s2("cli_test_history", 10);
+    s2.Store({ "item3" });
+    const std::vector<std::string> expected = { "item1", "item2", "item3" };
+    auto result = s2.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+    s2.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(LegacyFormat)
+{
+    {
+        std::ofstream f("cli_test_history", std::ios_base::trunc | std::ios_base::binary);
+        f << "item1\nitem2\n3:abc\n";
+    }
+    FileHistoryStorage s("cli_test_history", 10);
+    std::vector<std::string> expected = { "item1", "item2", "3:abc" };
+    auto result = s.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+
+    // the file is converted on the first store
+    s.Store({ "item4" });
+    expected.push_back("item4");
+    result = s.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+    BOOST_CHECK_EQUAL(FileContent("cli_test_history").compare(0, 1, "#"), 0);
+    s.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(Compaction)
+{
+    std::vector<std::string> expected;
+    {
+        FileHistoryStorage s("cli_test_history", 10);
+        s.Clear();
+        for (int i = 0; i < 100; ++i)
+            s.Store({ "item" + std::to_string(i) });
+        for (int i = 90; i < 100; ++i)
+            expected.push_back("item" + std::to_string(i));
+        auto result = s.Commands();
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+    } // waits for the compaction
+
+    // the old commands have been removed from the file
+    const std::string content = FileContent("cli_test_history");
+    BOOST_CHECK_LT(std::count(content.begin(), content.end(), '\n'), 50);
+
+    FileHistoryStorage s2("cli_test_history", 10);
+    auto result = s2.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+    s2.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(Sync)
+{
+    FileHistoryStorage s("cli_test_history", 10, FileHistoryStorage::Sync::always);
+    s.Clear();
+    const std::vector<std::string> v = { "item1", "item2" };
+    s.Store(v);
+    auto result = s.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(v.begin(), v.end(), result.begin(), result.end());
+    s.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot)
+{
+    FileHistoryStorage s("cli_test_history", 3);
+    s.Clear();
+    s.Store({ "item1", "item2", "item3", "item4" });
+
+    auto snapshot = s.Snapshot();
+    BOOST_CHECK_EQUAL(snapshot->Size(), 3u);
+    BOOST_CHECK_EQUAL(snapshot->At(0), "item2");
+    BOOST_CHECK_EQUAL(snapshot->At(2), "item4");
+
+    // the snapshot doesn't change
+    s.Store({ "itemA" });
+    s.Clear();
+    BOOST_CHECK_EQUAL(snapshot->Size(), 3u);
+    BOOST_CHECK_EQUAL(snapshot->At(0), "item2");
+    BOOST_CHECK_EQUAL(snapshot->At(2), "item4");
+
+    BOOST_CHECK_EQUAL(s.Snapshot()->Size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(ExternalTruncation)
+{
+    FileHistoryStorage s("cli_test_history", 10);
+    s.Clear();
+    s.Store({ "item1", "item2" });
+    auto snapshot = s.Snapshot();
+
+    // another application (e.g., an old version of the library) truncates the file:
+    // the snapshot doesn't depend on it
+    {
+        std::ofstream f("cli_test_history", std::ios_base::trunc | std::ios_base::binary);
+    }
+    BOOST_CHECK_EQUAL(snapshot->Size(), 2u);
+    BOOST_CHECK_EQUAL(snapshot->At(0), "item1");
+    BOOST_CHECK_EQUAL(snapshot->At(1), "item2");
+    BOOST_CHECK_EQUAL(snapshot->Find("item", 2), 1u);
+    BOOST_CHECK_EQUAL(s.Snapshot()->Size(), 0u);
+    s.Clear();
+}
+
+#if !defined(CLI_OS_WIN)
+BOOST_AUTO_TEST_CASE(ClearWithoutReplace)
+{
+    FileHistoryStorage s("cli_test_history", 3);
+    s.Clear();
+    s.Store({ "item1", "item2" });
+    auto snapshot = s.Snapshot();
+
+    // the temporary file can't be created, so the file can't be replaced:
+    // it's removed (it's never truncated)
+    ::mkdir("cli_test_history.tmp", 0700);
+    s.Clear();
+    ::rmdir("cli_test_history.tmp");
+
+    BOOST_CHECK(s.Commands().empty());
+    BOOST_CHECK_EQUAL(snapshot->Size(), 2u);
+    BOOST_CHECK_EQUAL(snapshot->At(1), "item2");
+    s.Store({ "item3" });
+    const std::vector<std::string> expected = { "item3" };
+    const auto result = s.Commands();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), result.begin(), result.end());
+    s.Clear();
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(SharedSnapshot)
+{
+    FileHistoryStorage s("cli_test_history", 10);
+    s.Clear();
+    s.Store({ "item1", "item2" });
+
+    // the sessions share the same snapshot until the file changes
+    auto snapshot = s.Snapshot();
+    BOOST_CHECK_EQUAL(snapshot, s.Snapshot());
+
+    s.Store({ "item3" });
+    auto snapshot2 = s.Snapshot();
+    BOOST_CHECK_NE(snapshot, snapshot2);
+    BOOST_CHECK_EQUAL(snapshot2->Size(), 3u);
+
+    // changed by another application
+    FileHistoryStorage other("cli_test_history", 10);
+    other.Store({ "item4" });
+    auto snapshot3 = s.Snapshot();
+    BOOST_CHECK_NE(snapshot2, snapshot3);
+    BOOST_CHECK_EQUAL(snapshot3->Size(), 4u);
+    BOOST_CHECK_EQUAL(snapshot3->At(3), "item4");
+    s.Clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
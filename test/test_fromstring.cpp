@@ -0,0 +1,181 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include "cli/detail/fromstring.h"
+#include <clocale>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace std;
+using namespace cli::detail;
+
+namespace {
+
+template <typename T>
+bool Accepted(const string& s)
+{
+    T value{};
+    return try_from_string(s, value);
+}
+
+template <typename T>
+T Convert(const string& s)
+{
+    T value{};
+    BOOST_CHECK_MESSAGE(try_from_string(s, value), "\"" << s << "\" not converted");
+    return value;
+}
+
+} // namespace
+
+// The test suite is built also with C++17, where the conversions use
+// std::from_chars (when available): the results must not change.
+BOOST_AUTO_TEST_SUITE(FromStringSuite)
+
+BOOST_AUTO_TEST_CASE(Integers)
+{
+    BOOST_CHECK_EQUAL(Convert<int>("42"), 42);
+    BOOST_CHECK_EQUAL(Convert<int>("+42"), 42);
+    BOOST_CHECK_EQUAL(Convert<int>("-42"), -42);
+    BOOST_CHECK_EQUAL(Convert<int>("-2147483648"), numeric_limits<int>::min());
+    BOOST_CHECK_EQUAL(Convert<unsigned int>("4294967295"), numeric_limits<unsigned int>::max());
+    BOOST_CHECK_EQUAL(Convert<long long>("-9223372036854775808"), numeric_limits<long long>::min());
+    BOOST_CHECK_EQUAL(Convert<short>("-32768"), numeric_limits<short>::min());
+
+    BOOST_CHECK(!Accepted<int>(""));
+    BOOST_CHECK(!Accepted<int>("+"));
+    BOOST_CHECK(!Accepted<int>("-"));
+    BOOST_CHECK(!Accepted<int>("+-1"));
+    BOOST_CHECK(!Accepted<int>("-+1"));
+    BOOST_CHECK(!Accepted<int>("++1"));
+    BOOST_CHECK(!Accepted<int>(" 1"));
+    BOOST_CHECK(!Accepted<int>("1 "));
+    BOOST_CHECK(!Accepted<int>("1.5"));
+    BOOST_CHECK(!Accepted<int>("0x10"));
+    BOOST_CHECK(!Accepted<int>("2147483648"));
+    BOOST_CHECK(!Accepted<int>("-2147483649"));
+    BOOST_CHECK(!Accepted<short>("32768"));
+    BOOST_CHECK(!Accepted<unsigned int>("-1"));
+    BOOST_CHECK(!Accepted<unsigned int>("-0"));
+    BOOST_CHECK(!Accepted<unsigned int>("4294967296"));
+    BOOST_CHECK(!Accepted<unsigned char>("256"));
+}
+
+BOOST_AUTO_TEST_CASE(Booleans)
+{
+    BOOST_CHECK(Convert<bool>("true"));
+    BOOST_CHECK(Convert<bool>("1"));
+    BOOST_CHECK(!Convert<bool>("false"));
+    BOOST_CHECK(!Convert<bool>("0"));
+    BOOST_CHECK(!Accepted<bool>("2"));
+    BOOST_CHECK(!Accepted<bool>("True"));
+}
+
+BOOST_AUTO_TEST_CASE(FloatingPoints)
+{
+    BOOST_CHECK_EQUAL(Convert<double>("1.5"), 1.5);
+    BOOST_CHECK_EQUAL(Convert<double>("+1.5"), 1.5);
+    BOOST_CHECK_EQUAL(Convert<double>("-1.5"), -1.5);
+    BOOST_CHECK_EQUAL(Convert<double>(".5"), 0.5);
+    BOOST_CHECK_EQUAL(Convert<double>("5."), 5.0);
+    BOOST_CHECK_EQUAL(Convert<double>("1e3"), 1000.0);
+    BOOST_CHECK_EQUAL(Convert<double>("1E-3"), 0.001);
+    BOOST_CHECK_EQUAL(Convert<float>("0.25"), 0.25f);
+    BOOST_CHECK_EQUAL(Convert<long double>("2.5"), 2.5L);
+
+    BOOST_CHECK(!Accepted<double>(""));
+    BOOST_CHECK(!Accepted<double>("."));
+    BOOST_CHECK(!Accepted<double>("+-1.5"));
+    BOOST_CHECK(!Accepted<double>(" 1.5"));
+    BOOST_CHECK(!Accepted<double>("1.5 "));
+    BOOST_CHECK(!Accepted<double>("1e"));
+    BOOST_CHECK(!Accepted<double>("1.5.5"));
+    BOOST_CHECK(!Accepted<double>("1e400"));
+    BOOST_CHECK(!Accepted<double>("-1e400"));
+    BOOST_CHECK(!Accepted<float>("1e40"));
+}
+
+BOOST_AUTO_TEST_CASE(FloatingPointsSpecialNotations)
+{
+    // hexadecimal notation
+    BOOST_CHECK_EQUAL(Convert<double>("0x10"), 16.0);
+    BOOST_CHECK_EQUAL(Convert<double>("-0x10"), -16.0);
+    BOOST_CHECK_EQUAL(Convert<double>("+0x10"), 16.0);
+    BOOST_CHECK_EQUAL(Convert<double>("0x1p3"), 8.0);
+    BOOST_CHECK_EQUAL(Convert<double>("0X1.8P1"), 3.0);
+    BOOST_CHECK_EQUAL(Convert<float>("0x.8"), 0.5f);
+    BOOST_CHECK(!Accepted<double>("0x"));
+    BOOST_CHECK(!Accepted<double>("0x-1"));
+    BOOST_CHECK(!Accepted<double>("0x+1"));
+    BOOST_CHECK(!Accepted<double>("0xg"));
+    BOOST_CHECK(!Accepted<double>("0x1p"));
+
+    // infinity and nan
+    BOOST_CHECK_EQUAL(Convert<double>("inf"), numeric_limits<double>::infinity());
+    BOOST_CHECK_EQUAL(Convert<double>("-INF"), -numeric_limits<double>::infinity());
+    BOOST_CHECK_EQUAL(Convert<double>("+Infinity"), numeric_limits<double>::infinity());
+    BOOST_CHECK_EQUAL(Convert<float>("-infinity"), -numeric_limits<float>::infinity());
+    BOOST_CHECK(std::isnan(Convert<double>("nan")));
+    BOOST_CHECK(std::isnan(Convert<float>("NAN")));
+    BOOST_CHECK(std::isnan(Convert<long double>("-nan")));
+    BOOST_CHECK(!Accepted<double>("in"));
+    BOOST_CHECK(!Accepted<double>("infin"));
+    BOOST_CHECK(!Accepted<double>("nanx"));
+    BOOST_CHECK(!Accepted<double>(" inf"));
+}
+
+BOOST_AUTO_TEST_CASE(FloatingPointsLocale)
+{
+    // the decimal point is always '.', whatever the locale
+    const char* locales[] = { "de_DE.UTF-8", "de_DE.utf8", "it_IT.UTF-8", "fr_FR.UTF-8", "German" };
+    const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+    bool found = false;
+    for (const char* l: locales)
+        if (std::setlocale(LC_NUMERIC, l) != nullptr && std::strcmp(std::localeconv()->decimal_point, ",") == 0)
+        {
+            found = true;
+            break;
+        }
+    if (!found)
+    {
+        std::setlocale(LC_NUMERIC, previous.c_str());
+        BOOST_TEST_MESSAGE("no locale with ',' as decimal point available");
+        return;
+    }
+    const double d = Convert<double>("1.5");
+    const bool comma = Accepted<double>("1,5");
+    std::setlocale(LC_NUMERIC, previous.c_str());
+    BOOST_CHECK_EQUAL(d, 1.5);
+    BOOST_CHECK(!comma);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,11 +28,27 @@
  ******************************************************************************/
 
 #include <boost/test/unit_test.hpp>
+#include <sstream>
 #include "cli/detail/history.h"
 
 using namespace cli;
 using namespace cli::detail;
 
+namespace
+{
+// counts the commands copied from the snapshot
+class CountingSnapshot : public HistorySnapshot
+{
+public:
+    explicit CountingSnapshot(std::size_t _size) : size(_size) {}
+    std::size_t Size() const override { return size; }
+    std::string At(std::size_t i) const override { ++copies; return "item" + std::to_string(i+1); }
+    mutable std::size_t copies = 0;
+private:
+    const std::size_t size;
+};
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(HistorySuite)
 
 BOOST_AUTO_TEST_CASE(NotFull)
@@ -237,4 +253,138 @@ BOOST_AUTO_TEST_CASE(Copies)
     BOOST_CHECK_EQUAL_COLLECTIONS(cmds2.begin(), cmds2.end(), expected2.begin(), expected2.end());
 }
 
+BOOST_AUTO_TEST_CASE(LongRunning)
+{
+    // the ring buffer wraps around many times
+    History history(3);
+    for (int i = 0; i < 100; ++i)
+    {
+        history.NewCommand("item" + std::to_string(i));
+        if (i % 7 == 0)
+        {
+            BOOST_CHECK_EQUAL(history.Previous(""), "item" + std::to_string(i));
+            history.NewCommand("item" + std::to_string(i)); // re-executes the last one
+        }
+    }
+
+    BOOST_CHECK_THROW(history.At(96), std::out_of_range);
+    BOOST_CHECK_EQUAL(history.At(97), "item97");
+    BOOST_CHECK_EQUAL(history.At(99), "item99");
+
+    std::stringstream out;
+    history.Show(out);
+    BOOST_CHECK_EQUAL(out.str(), "\n97\titem97\n98\titem98\n99\titem99\n\n");
+
+    auto cmds = history.GetCommands();
+    const std::vector<std::string> expected = { "item97", "item98", "item99" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(cmds.begin(), cmds.end(), expected.begin(), expected.end());
+
+    BOOST_CHECK_EQUAL(history.Previous("new"), "item99");
+    BOOST_CHECK_EQUAL(history.Previous("item99"), "item98");
+    BOOST_CHECK_EQUAL(history.Previous("item98"), "item98"); // "new" dropped the oldest
+    BOOST_CHECK_EQUAL(history.Next(), "item99");
+    BOOST_CHECK_EQUAL(history.Next(), "new");
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot)
+{
+    // same as Copies, with the commands loaded from a snapshot
+    History history(10);
+
+    history.LoadCommands(std::make_shared<VectorHistorySnapshot>(std::vector<std::string>{ "item1", "item2", "item3" }));
+
+    BOOST_CHECK_EQUAL(history.At(0), "item1");
+    BOOST_CHECK_EQUAL(history.At(1), "item2");
+    BOOST_CHECK_EQUAL(history.At(2), "item3");
+
+    BOOST_CHECK_EQUAL(history.Previous(""), "item3");
+    BOOST_CHECK_EQUAL(history.Previous("item3"), "item2");
+    BOOST_CHECK_EQUAL(history.Previous("item2"), "item1");
+    BOOST_CHECK_EQUAL(history.Previous("item1"), "item1");
+
+    history.NewCommand("itemA");
+    history.NewCommand("itemB");
+
+    BOOST_CHECK_EQUAL(history.At(0), "item1");
+    BOOST_CHECK_EQUAL(history.At(3), "itemA");
+    BOOST_CHECK_EQUAL(history.At(4), "itemB");
+
+    auto cmds = history.GetCommands();
+    const std::vector<std::string> expected = { "itemA", "itemB" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(cmds.begin(), cmds.end(), expected.begin(), expected.end());
+
+    History history1(3);
+    history1.LoadCommands(std::make_shared<VectorHistorySnapshot>(std::vector<std::string>{ "item1", "item2", "item3", "item4" }));
+
+    BOOST_CHECK_THROW(history1.At(0), std::out_of_range);
+    BOOST_CHECK_EQUAL(history1.At(1), "item2");
+    BOOST_CHECK_EQUAL(history1.At(3), "item4");
+
+    history1.NewCommand("itemA");
+    BOOST_CHECK_THROW(history1.At(1), std::out_of_range);
+    BOOST_CHECK_EQUAL(history1.At(2), "item3");
+    BOOST_CHECK_EQUAL(history1.At(4), "itemA");
+
+    BOOST_CHECK_EQUAL(history1.Previous(""), "itemA");
+    BOOST_CHECK_EQUAL(history1.Previous("itemA"), "item4");
+    BOOST_CHECK_EQUAL(history1.Previous("item4x"), "item4x"); // can't go beyond the oldest
+    BOOST_CHECK_EQUAL(history1.Next(), "itemA");
+}
+
+BOOST_AUTO_TEST_CASE(SnapshotLazy)
+{
+    auto snapshot = std::make_shared<CountingSnapshot>(100000);
+    History history(1000);
+    history.LoadCommands(snapshot);
+    history.NewCommand("itemA"); // compared with the newest command
+    BOOST_CHECK_EQUAL(snapshot->copies, 1u);
+
+    // only the commands browsed are copied
+    BOOST_CHECK_EQUAL(history.Previous(""), "itemA");
+    BOOST_CHECK_EQUAL(history.Previous("itemA"), "item100000");
+    BOOST_CHECK_EQUAL(history.Previous("item100000"), "item99999");
+    BOOST_CHECK_EQUAL(snapshot->copies, 3u);
+    BOOST_CHECK_THROW(history.At(99001), std::out_of_range);
+    BOOST_CHECK_EQUAL(history.At(99002), "item99003");
+
+    history.NewCommand("itemB");
+    auto cmds = history.GetCommands();
+    const std::vector<std::string> expected = { "itemA", "itemB" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(cmds.begin(), cmds.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(Search)
+{
+    History history(5);
+    history.LoadCommands(std::make_shared<VectorHistorySnapshot>(std::vector<std::string>{ "foo 1", "bar 2", "foo 3", "bar 4", "foo 5" }));
+    history.NewCommand("foo 6");
+    history.NewCommand("bar 7");
+    // visible (newest first): bar 7, foo 6, foo 5, bar 4, foo 3
+
+    std::size_t index = 0;
+    std::string item;
+    BOOST_CHECK(history.Search("foo", index, item));
+    BOOST_CHECK_EQUAL(index, 1u);
+    BOOST_CHECK_EQUAL(item, "foo 6");
+    ++index;
+    BOOST_CHECK(history.Search("foo", index, item));
+    BOOST_CHECK_EQUAL(index, 2u);
+    BOOST_CHECK_EQUAL(item, "foo 5");
+    ++index;
+    BOOST_CHECK(history.Search("foo", index, item));
+    BOOST_CHECK_EQUAL(index, 4u);
+    BOOST_CHECK_EQUAL(item, "foo 3");
+    ++index;
+    BOOST_CHECK(!history.Search("foo", index, item)); // "foo 1" is not in the history anymore
+
+    index = 0;
+    BOOST_CHECK(history.Search("r 4", index, item));
+    BOOST_CHECK_EQUAL(index, 3u);
+    BOOST_CHECK_EQUAL(item, "bar 4");
+    BOOST_CHECK_EQUAL(history.At(6 - index), item); // ids from 2 (oldest) to 6 (newest)
+
+    index = 0;
+    BOOST_CHECK(!history.Search("baz", index, item));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
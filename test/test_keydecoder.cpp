@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cli/detail/keydecoder.h"
+
+using namespace std;
+using namespace cli::detail;
+
+namespace
+{
+vector<pair<KeyType,char>> Decode(KeyDecoder& decoder, const string& input)
+{
+    vector<pair<KeyType,char>> keys;
+    for (char c: input)
+    {
+        pair<KeyType,char> key;
+        if (decoder.Feed(c, key))
+            keys.push_back(key);
+    }
+    return keys;
+}
+
+bool Is(const vector<pair<KeyType,char>>& keys, const vector<KeyType>& expected)
+{
+    if (keys.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < keys.size(); ++i)
+        if (keys[i].first != expected[i])
+            return false;
+    return true;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(KeyDecoderSuite)
+
+BOOST_AUTO_TEST_CASE(SingleKeys)
+{
+    KeyDecoder decoder;
+    auto keys = Decode(decoder, "a\x7f\b\n\x0c\x04\x03");
+    BOOST_CHECK(Is(keys, {KeyType::ascii, KeyType::backspace, KeyType::backspace, KeyType::ret, KeyType::clear, KeyType::eof, KeyType::interrupt}));
+    BOOST_CHECK_EQUAL(keys[0].second, 'a');
+    BOOST_CHECK(decoder.Idle());
+}
+
+BOOST_AUTO_TEST_CASE(EscapeSequences)
+{
+    KeyDecoder decoder;
+    auto keys = Decode(decoder, "\x1b[A\x1b[B\x1b[D\x1b[C\x1b[F\x1b[H\x1b[3~");
+    BOOST_CHECK(Is(keys, {KeyType::up, KeyType::down, KeyType::left, KeyType::right, KeyType::end, KeyType::home, KeyType::canc}));
+
+    // unknown sequences are ignored, and the decoder restarts
+    keys = Decode(decoder, "\x1bx\x1b[Z\x1b[3xa");
+    BOOST_CHECK(Is(keys, {KeyType::ignored, KeyType::ignored, KeyType::ignored, KeyType::ascii}));
+}
+
+BOOST_AUTO_TEST_CASE(SplitSequence)
+{
+    // the sequence can be split among different reads
+    KeyDecoder decoder;
+    BOOST_CHECK(Decode(decoder, "\x1b").empty());
+    BOOST_CHECK(!decoder.Idle());
+    BOOST_CHECK(Decode(decoder, "[3").empty());
+    BOOST_CHECK(!decoder.Idle());
+    BOOST_CHECK(Is(Decode(decoder, "~"), {KeyType::canc}));
+    BOOST_CHECK(decoder.Idle());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
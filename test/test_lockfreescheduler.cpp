@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "scheduler_test_templates.h"
+#include <memory>
+#include "cli/lockfreescheduler.h"
+
+using namespace std;
+using namespace cli;
+
+BOOST_AUTO_TEST_SUITE(LockFreeSchedulerSuite)
+
+BOOST_AUTO_TEST_CASE(Basics)
+{
+    SchedulingTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(SameThread)
+{
+    SameThreadTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(Exceptions)
+{
+    ExceptionTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(Timers)
+{
+    TimerTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(TimersCancel)
+{
+    TimerCancelTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(MultiProducer)
+{
+    MultiProducerTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(Stop)
+{
+    StopTest<LockFreeScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(MoveOnlyTasks)
+{
+    LockFreeScheduler scheduler;
+    int result = 0;
+    auto value = make_unique<int>(42);
+    scheduler.Post( [&result, v = std::move(value)]() { result = *v; } );
+    // a task bigger than the small buffer
+    char big[256] = {};
+    big[255] = 1;
+    scheduler.Post( [&result, big]() { result += big[255]; } );
+    // an empty std::function is skipped
+    scheduler.Post( std::function<void()>() );
+    BOOST_CHECK(scheduler.PollOne());
+    BOOST_CHECK(scheduler.PollOne());
+    BOOST_CHECK(scheduler.PollOne());
+    BOOST_CHECK(!scheduler.PollOne());
+    BOOST_CHECK_EQUAL(result, 43);
+}
+
+BOOST_AUTO_TEST_CASE(PendingTasksDestroyed)
+{
+    auto counter = make_shared<int>(0);
+    {
+        LockFreeScheduler scheduler;
+        scheduler.Post( [counter](){} );
+        scheduler.Post( [counter](){} );
+        BOOST_CHECK_EQUAL(counter.use_count(), 3);
+    }
+    BOOST_CHECK_EQUAL(counter.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -50,4 +50,128 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     ExceptionTest<LoopScheduler>();
 }
 
+BOOST_AUTO_TEST_CASE(Timers)
+{
+    TimerTest<LoopScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(TimersCancel)
+{
+    TimerCancelTest<LoopScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(MultiProducer)
+{
+    MultiProducerTest<LoopScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(Stop)
+{
+    StopTest<LoopScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(RunBatch)
+{
+    LoopScheduler scheduler;
+    vector<int> order;
+    for (int i = 0; i < 5; ++i)
+        scheduler.Post( [&, i](){ order.push_back(i); } );
+
+    BOOST_CHECK_EQUAL(scheduler.RunBatch(3), 3u);
+    BOOST_CHECK_EQUAL(order.size(), 3u);
+
+    // the tasks posted during the batch run in the next one
+    scheduler.Post( [&](){ order.push_back(5); scheduler.Post( [&](){ order.push_back(6); } ); } );
+    BOOST_CHECK_EQUAL(scheduler.RunBatch(), 3u);
+    BOOST_CHECK_EQUAL(scheduler.RunBatch(), 1u);
+
+    const vector<int> expected = {0, 1, 2, 3, 4, 5, 6};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+    BOOST_CHECK(!scheduler.PollOne());
+}
+
+BOOST_AUTO_TEST_CASE(RunBatchExceptions)
+{
+    LoopScheduler scheduler;
+    vector<int> order;
+    scheduler.Post( [&](){ order.push_back(0); } );
+    scheduler.Post( [](){ throw 42; } );
+    scheduler.Post( [&](){ order.push_back(1); } );
+    scheduler.Post( [&](){ order.push_back(2); } );
+
+    BOOST_CHECK_THROW(scheduler.RunBatch(), int);
+    BOOST_CHECK_EQUAL(order.size(), 1u);
+
+    // the tasks not executed are still in the queue, in the same order
+    scheduler.Post( [&](){ order.push_back(3); } );
+    BOOST_CHECK_EQUAL(scheduler.PollAll(), 3u);
+    const vector<int> expected = {0, 1, 2, 3};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(RunBatchStop)
+{
+    LoopScheduler scheduler;
+    int executed = 0;
+    scheduler.Post( [&](){ ++executed; scheduler.Stop(); } );
+    scheduler.Post( [&](){ ++executed; } );
+    scheduler.Run();
+    BOOST_CHECK_EQUAL(executed, 1);
+    BOOST_CHECK_EQUAL(scheduler.RunBatch(), 0u);
+    BOOST_CHECK_EQUAL(scheduler.PollAll(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(PollAll)
+{
+    LoopScheduler scheduler;
+    BOOST_CHECK_EQUAL(scheduler.PollAll(), 0u);
+
+    int executed = 0;
+    // a chain of tasks posting the next one
+    function<void()> task = [&]()
+    {
+        if (++executed < 10)
+            scheduler.Post(task);
+    };
+    scheduler.Post(task);
+    scheduler.PostAfter( chrono::hours(1), [&](){ executed = -1; } );
+    BOOST_CHECK_EQUAL(scheduler.PollAll(), 10u);
+    BOOST_CHECK_EQUAL(executed, 10);
+}
+
+BOOST_AUTO_TEST_CASE(BoundedQueue)
+{
+    LoopScheduler scheduler(2);
+    atomic<int> posted{ 0 };
+    int executed = 0;
+
+    thread producer( [&]()
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            scheduler.Post( [&](){ ++executed; } );
+            ++posted;
+        }
+    } );
+    // the producer can't go beyond the size of the queue
+    while (posted < 2)
+        this_thread::yield();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    BOOST_CHECK_EQUAL(posted.load(), 2);
+
+    while (executed < 100)
+        scheduler.RunBatch();
+    producer.join();
+    BOOST_CHECK_EQUAL(posted.load(), 100);
+
+    // the thread running the tasks is never blocked
+    scheduler.Post( [&]()
+    {
+        for (int i = 0; i < 10; ++i)
+            scheduler.Post( [&](){ ++executed; } );
+    } );
+    BOOST_CHECK_EQUAL(scheduler.PollAll(), 11u);
+    BOOST_CHECK_EQUAL(executed, 110);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -34,6 +34,35 @@ using namespace std;
 using namespace cli;
 using namespace cli::detail;
 
+namespace {
+
+// a command handling also the lines starting with its alias,
+// and completing both its name and its alias
+class AliasCommand : public Command
+{
+public:
+    AliasCommand() : Command("long") {}
+    using Command::Exec;
+    bool Exec(CmdLineView cmdLine, CliSession& session) override
+    {
+        if (cmdLine.empty() || (cmdLine[0] != Name() && cmdLine[0] != "l")) return false;
+        session.OutStream() << "long\n";
+        return true;
+    }
+    bool DispatchByName() const override { return false; }
+    vector<string> GetCompletionRecursive(const string& line) const override
+    {
+        vector<string> result;
+        if (string("long").rfind(line, 0) == 0) result.push_back("long");
+        if (string("l").rfind(line, 0) == 0) result.push_back("l");
+        if (line.rfind("l ", 0) == 0) result.push_back("l now");
+        return result;
+    }
+    void Help(ostream& out) const override { out << " - " << Name() << '\n'; }
+};
+
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(MenuSuite)
 
 BOOST_AUTO_TEST_CASE(Basics)
@@ -121,4 +150,66 @@ BOOST_AUTO_TEST_CASE(Basics)
     BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
 }
 
+BOOST_AUTO_TEST_CASE(CompletionsAfterChanges)
+{
+    Menu menu("menu");
+    auto zzz = menu.Insert("zzz", [](ostream&){});
+    menu.Insert("aaa", [](ostream&){});
+    auto aab = menu.Insert("aab", [](ostream&){});
+    auto sub = make_unique<Menu>("aa");
+    sub->Insert("foo", [](ostream&){});
+    menu.Insert(std::move(sub));
+
+    // in insertion order, with the menu whose name is a prefix of the line
+    auto completions = menu.GetCompletions("aa");
+    vector<string> expected({"aaa", "aab", "aa foo", "aa menu"});
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    completions = menu.GetCompletions("aa f");
+    expected = {"aa foo"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    aab.Disable();
+    completions = menu.GetCompletions("aa");
+    expected = {"aaa", "aa foo", "aa menu"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    aab.Enable();
+    aab.Remove();
+    menu.Insert("aac", [](ostream&){});
+    completions = menu.GetCompletions("aa");
+    expected = {"aaa", "aa foo", "aa menu", "aac"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    zzz.Remove();
+    completions = menu.GetCompletions("");
+    expected = {"aaa", "aa", "aac"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    completions = menu.GetCompletions("b");
+    BOOST_CHECK(completions.empty());
+}
+
+BOOST_AUTO_TEST_CASE(CompletionsOfCommandsNotDispatchedByName)
+{
+    Menu menu("menu");
+    menu.Insert("aaa", [](ostream&){});
+    menu.Insert(make_unique<AliasCommand>());
+    menu.Insert("lab", [](ostream&){});
+
+    // the command is asked even if its name doesn't match the line
+    auto completions = menu.GetCompletions("l ");
+    vector<string> expected({"l now"});
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    // once, in insertion order
+    completions = menu.GetCompletions("l");
+    expected = {"long", "l", "lab"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+
+    completions = menu.GetCompletions("a");
+    expected = {"aaa"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(completions.begin(), completions.end(), expected.begin(), expected.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include <deque>
+#include <random>
+#include <string>
+#include "cli/detail/ringbuffer.h"
+
+using namespace std;
+using namespace cli::detail;
+
+BOOST_AUTO_TEST_SUITE(RingBufferSuite)
+
+BOOST_AUTO_TEST_CASE(Basics)
+{
+    RingBuffer<int> r(3);
+    BOOST_CHECK(r.Empty());
+    BOOST_CHECK_EQUAL(r.Capacity(), 3u);
+
+    r.PushBack(1);
+    r.PushBack(2);
+    r.PushFront(0);
+    BOOST_CHECK(r.Full());
+    BOOST_CHECK_EQUAL(r[0], 0);
+    BOOST_CHECK_EQUAL(r[1], 1);
+    BOOST_CHECK_EQUAL(r[2], 2);
+
+    // when full, a push drops the item on the other end
+    r.PushBack(3);
+    BOOST_CHECK_EQUAL(r.Size(), 3u);
+    BOOST_CHECK_EQUAL(r[0], 1);
+    BOOST_CHECK_EQUAL(r[2], 3);
+    r.PushFront(4);
+    BOOST_CHECK_EQUAL(r[0], 4);
+    BOOST_CHECK_EQUAL(r[1], 1);
+    BOOST_CHECK_EQUAL(r[2], 2);
+
+    r.PopFront();
+    r.PopBack();
+    BOOST_CHECK_EQUAL(r.Size(), 1u);
+    BOOST_CHECK_EQUAL(r[0], 1);
+
+    r.Clear();
+    BOOST_CHECK(r.Empty());
+
+    // zero capacity
+    RingBuffer<int> z(0);
+    z.PushBack(1);
+    z.PushFront(2);
+    BOOST_CHECK(z.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(Random)
+{
+    // compares the ring with a deque
+    mt19937 gen(42);
+    for (size_t capacity: { 1, 2, 5, 16 })
+    {
+        RingBuffer<int> r(capacity);
+        deque<int> d;
+        for (int i = 0; i < 2000; ++i)
+        {
+            switch (gen() % 4)
+            {
+                case 0:
+                    r.PushBack(i);
+                    d.push_back(i);
+                    if (d.size() > capacity) d.pop_front();
+                    break;
+                case 1:
+                    r.PushFront(i);
+                    d.push_front(i);
+                    if (d.size() > capacity) d.pop_back();
+                    break;
+                case 2:
+                    if (!d.empty()) { r.PopFront(); d.pop_front(); }
+                    break;
+                default:
+                    if (!d.empty()) { r.PopBack(); d.pop_back(); }
+                    break;
+            }
+            BOOST_REQUIRE_EQUAL(r.Size(), d.size());
+            for (size_t j = 0; j < d.size(); ++j)
+                BOOST_REQUIRE_EQUAL(r[j], d[j]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReusesStrings)
+{
+    RingBuffer<string> r(2);
+    r.PushBack(string(100, 'a'));
+    r.PushBack(string(100, 'b'));
+    const char* oldest = r[0].data();
+
+    // the new item is copied in the string of the oldest
+    r.PushBack(string(50, 'c'));
+    BOOST_CHECK_EQUAL(r[0], string(100, 'b'));
+    BOOST_CHECK_EQUAL(r[1], string(50, 'c'));
+    BOOST_CHECK(r[1].data() == oldest);
+
+    // also the popped ones are reused
+    const char* newest = r[1].data();
+    r.PopBack();
+    r.PushFront(string(20, 'd'));
+    BOOST_CHECK_EQUAL(r[0], string(20, 'd'));
+    BOOST_CHECK(r[0].data() == newest);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -284,4 +284,54 @@ BOOST_AUTO_TEST_CASE(Symbols)
     BOOST_CHECK_EQUAL(strs[4], "72 ! 33");
 }
 
+
+BOOST_AUTO_TEST_CASE(VectorReuse)
+{
+    VS strs = { "a previous content long enough to be allocated on the heap", "foo", "bar", "", "baz" };
+    const auto firstData = strs[0].data();
+
+    split(strs, R"(first "" second '' "a quite long third token that needs the heap")");
+    BOOST_CHECK_EQUAL(strs.size(), 3);
+    BOOST_CHECK(strs[0].data() == firstData); // the buffer is reused
+    BOOST_CHECK_EQUAL(strs[0], "first");
+    BOOST_CHECK_EQUAL(strs[1], "second");
+    BOOST_CHECK_EQUAL(strs[2], "a quite long third token that needs the heap");
+
+    split(strs, "one");
+    BOOST_CHECK_EQUAL(strs.size(), 1);
+    BOOST_CHECK_EQUAL(strs[0], "one");
+
+    split(strs, R"(one "two 'three'" \"four\" five\)");
+    BOOST_CHECK_EQUAL(strs.size(), 4);
+    BOOST_CHECK_EQUAL(strs[0], "one");
+    BOOST_CHECK_EQUAL(strs[1], "two 'three'");
+    BOOST_CHECK_EQUAL(strs[2], R"("four")");
+    BOOST_CHECK_EQUAL(strs[3], "five");
+
+    split(strs, "  ");
+    BOOST_CHECK(strs.empty());
+
+    // SplitInto returns the number of tokens, and keeps the other strings
+    VS buffers;
+    BOOST_CHECK_EQUAL(SplitInto(buffers, R"(first "a quite long second token that needs the heap" third)"), 3u);
+    BOOST_CHECK_EQUAL(buffers[1], "a quite long second token that needs the heap");
+    const auto data = buffers[1].data();
+    const auto capacity = buffers[1].capacity();
+
+    // a shorter line doesn't destroy the strings after its tokens
+    BOOST_CHECK_EQUAL(SplitInto(buffers, "one"), 1u);
+    BOOST_CHECK_EQUAL(buffers[0], "one");
+    BOOST_REQUIRE_EQUAL(buffers.size(), 3u);
+    BOOST_CHECK(buffers[1].data() == data);
+    BOOST_CHECK_EQUAL(buffers[1].capacity(), capacity);
+
+    BOOST_CHECK_EQUAL(SplitInto(buffers, "  "), 0u);
+    BOOST_CHECK_EQUAL(buffers.size(), 3u);
+
+    // the next long line reuses the buffer
+    BOOST_CHECK_EQUAL(SplitInto(buffers, R"(one "another long token, that fits the same buffer")"), 2u);
+    BOOST_CHECK_EQUAL(buffers[1], "another long token, that fits the same buffer");
+    BOOST_CHECK(buffers[1].data() == data);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -50,6 +50,16 @@ BOOST_AUTO_TEST_CASE(Exceptions)
     ExceptionTest<StandaloneAsioScheduler>();
 }
 
+BOOST_AUTO_TEST_CASE(Timers)
+{
+    TimerTest<StandaloneAsioScheduler>();
+}
+
+BOOST_AUTO_TEST_CASE(TimersCancel)
+{
+    TimerCancelTest<StandaloneAsioScheduler>();
+}
+
 BOOST_AUTO_TEST_CASE(StandaloneAsioNonOwner)
 {
     detail::StandaloneAsioLib::ContextType ioc;
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <string>
+#include "cli/detail/telnetscanner.h"
+
+using namespace std;
+using namespace cli::detail;
+
+namespace
+{
+const char* FindSpecialReference(const char* first, const char* last)
+{
+    while (first != last && !IsTelnetSpecial(*first))
+        ++first;
+    return first;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TelnetScannerSuite)
+
+BOOST_AUTO_TEST_CASE(SpecialChars)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        const char c = static_cast<char>(i);
+        const bool expected = (i < 0x20 || i == 0x7F || i == 0xFF);
+        BOOST_CHECK_EQUAL(IsTelnetSpecial(c), expected);
+        // in every position of a block longer than a vector register
+        for (size_t pos = 0; pos < 40; ++pos)
+        {
+            string s(40, 'a');
+            s[pos] = c;
+            const char* found = FindTelnetSpecial(s.data(), s.data() + s.size());
+            BOOST_CHECK_EQUAL(found - s.data(), static_cast<ptrdiff_t>(expected ? pos : s.size()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    const string s;
+    BOOST_CHECK(FindTelnetSpecial(s.data(), s.data()) == s.data());
+}
+
+BOOST_AUTO_TEST_CASE(Random)
+{
+    mt19937 gen(42);
+    uniform_int_distribution<int> byte(0, 255);
+    uniform_int_distribution<int> sparse(0, 63);
+    for (int n = 0; n < 1000; ++n)
+    {
+        string s(static_cast<size_t>(sparse(gen)), ' ');
+        for (auto& c: s)
+            c = static_cast<char>(sparse(gen) == 0 ? byte(gen) : 'a' + (byte(gen) % 26));
+        for (size_t offset = 0; offset < s.size(); ++offset)
+        {
+            const char* first = s.data() + offset;
+            const char* last = s.data() + s.size();
+            BOOST_CHECK(FindTelnetSpecial(first, last) == FindSpecialReference(first, last));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,305 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include "cli/cli.h"
+#include "cli/boostasioscheduler.h"
+#include "cli/boostasioremotecli.h"
+#include <thread>
+
+using namespace std;
+using namespace cli;
+
+namespace {
+
+std::size_t Count(const string& s, const string& what)
+{
+    std::size_t n = 0;
+    for (auto pos = s.find(what); pos != string::npos; pos = s.find(what, pos + what.size()))
+        ++n;
+    return n;
+}
+
+// a blocking telnet client on the loopback interface
+class Client
+{
+public:
+    // receiveBuffer limits the output the client can get without reading it
+    explicit Client(unsigned short port, int receiveBuffer = 0) : socket(ioc)
+    {
+        socket.open(boost::asio::ip::tcp::v4());
+        if (receiveBuffer > 0)
+            socket.set_option(boost::asio::socket_base::receive_buffer_size(receiveBuffer));
+        socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+    }
+    void Send(const string& s)
+    {
+        boost::asio::write(socket, boost::asio::buffer(s));
+    }
+    // reads until the output received contains s (count times),
+    // returns false if the connection is closed
+    bool ReadUntil(const string& s, std::size_t count = 1)
+    {
+        while (Count(received, s) < count)
+        {
+            char buf[1024];
+            boost::system::error_code ec;
+            const auto n = socket.read_some(boost::asio::buffer(buf), ec);
+            if (ec) return false;
+            received.append(buf, n);
+        }
+        return true;
+    }
+    // reads the output available, waiting for some if there is none
+    string ReadSome()
+    {
+        char buf[64 * 1024];
+        const auto n = socket.read_some(boost::asio::buffer(buf));
+        return string(buf, n);
+    }
+    // reads (and discards) the output until the connection is closed,
+    // returns the number of bytes read
+    std::size_t ReadToEnd()
+    {
+        std::size_t total = 0;
+        while (true)
+        {
+            char buf[64 * 1024];
+            boost::system::error_code ec;
+            const auto n = socket.read_some(boost::asio::buffer(buf), ec);
+            if (ec) return total;
+            total += n;
+        }
+    }
+    const string& Received() const { return received; }
+private:
+    boost::asio::io_context ioc;
+    boost::asio::ip::tcp::socket socket;
+    string received;
+};
+
+// a telnet server on the loopback interface, running in its own thread
+struct TestServer
+{
+    explicit TestServer(unique_ptr<Menu> rootMenu) :
+        cli(std::move(rootMenu)),
+        server(cli, scheduler, "127.0.0.1", 0)
+    {}
+    ~TestServer()
+    {
+        scheduler.Stop();
+        if (thread.joinable())
+            thread.join();
+    }
+    void Start() { thread = std::thread([this](){ scheduler.Run(); }); }
+
+    Cli cli;
+    BoostAsioScheduler scheduler;
+    BoostAsioCliTelnetServer server;
+    std::thread thread;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TelnetServerSuite)
+
+BOOST_AUTO_TEST_CASE(CoutWithWorkerThreads, * boost::unit_test::timeout(60))
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("ping", [](ostream& out){ out << "pong\n"; });
+    TestServer test(std::move(rootMenu));
+    test.server.WorkerThreads(4);
+    const auto port = test.server.Port();
+    test.Start();
+
+    const std::size_t nClients = 8;
+    const std::size_t nCommands = 50;
+    const int nBroadcasts = 200;
+    vector<unique_ptr<Client>> clients;
+    for (std::size_t i = 0; i < nClients; ++i)
+    {
+        clients.push_back(make_unique<Client>(port));
+        // the session is registered on Cli::cout when it shows the prompt
+        BOOST_REQUIRE(clients.back()->ReadUntil("cli>"));
+    }
+
+    // the sessions write their output while Cli::cout writes on all of them
+    thread broadcaster([&]()
+    {
+        for (int i = 0; i < nBroadcasts; ++i)
+            Cli::cout() << "[bc " + to_string(i) + "]\n";
+    });
+    vector<thread> readers;
+    for (auto& c: clients)
+        readers.emplace_back([&c, nCommands]()
+        {
+            for (std::size_t i = 0; i < nCommands; ++i)
+                c->Send("ping\r\n");
+            c->ReadUntil("pong\r\n", nCommands);
+            c->ReadUntil("[bc " + to_string(nBroadcasts-1) + "]");
+        });
+    broadcaster.join();
+    for (auto& r: readers)
+        r.join();
+
+    for (auto& c: clients)
+    {
+        const string& out = c->Received();
+        BOOST_CHECK_EQUAL(Count(out, "pong\r\n"), nCommands);
+        // every session gets all the Cli::cout output, in order
+        std::size_t pos = 0;
+        for (int i = 0; i < nBroadcasts; ++i)
+        {
+            pos = out.find("[bc " + to_string(i) + "]\r\n", pos);
+            BOOST_REQUIRE(pos != string::npos);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Buffering, * boost::unit_test::timeout(60))
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("lines", [](ostream& out)
+    {
+        for (int i = 0; i < 10; ++i)
+            out << "line " << i << endl;
+    });
+    TestServer test(std::move(rootMenu));
+    test.Start();
+
+    Client client(test.server.Port());
+    BOOST_REQUIRE(client.ReadUntil("cli>"));
+    client.Send("lines\r\n");
+    // the echo, the flushed lines and the prompt are written together
+    // at the end of the command
+    const string out = client.ReadSome();
+    BOOST_CHECK(out.find("line 0\r\n") != string::npos);
+    BOOST_CHECK(out.find("line 9\r\n") != string::npos);
+    BOOST_CHECK(out.find("cli>") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(FlushThreshold, * boost::unit_test::timeout(60))
+{
+    const std::size_t nLines = 1000;
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("lines", [nLines](ostream& out)
+    {
+        for (std::size_t i = 0; i < nLines; ++i)
+            out << "line " << i << '\n';
+    });
+    TestServer test(std::move(rootMenu));
+    // the output is written in chunks while the command runs
+    test.server.OutputLimits(64, 1024 * 1024);
+    test.Start();
+
+    Client client(test.server.Port());
+    BOOST_REQUIRE(client.ReadUntil("cli>"));
+    client.Send("lines\r\n");
+    BOOST_REQUIRE(client.ReadUntil("cli>", 2));
+    const string& out = client.Received();
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < nLines; ++i)
+    {
+        pos = out.find("line " + to_string(i) + "\r\n", pos);
+        BOOST_REQUIRE(pos != string::npos);
+    }
+}
+
+namespace {
+unique_ptr<Menu> FloodMenu()
+{
+    auto rootMenu = make_unique<Menu>("cli");
+    rootMenu->Insert("flood", [](ostream& out, std::size_t nLines)
+    {
+        const string line(99, 'x');
+        for (std::size_t i = 0; i < nLines; ++i)
+            out << line << '\n';
+        out << "end of flood\n";
+    });
+    rootMenu->Insert("ping", [](ostream& out){ out << "pong\n"; });
+    return rootMenu;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(HighWaterMark, * boost::unit_test::timeout(60))
+{
+    TestServer test(FloodMenu());
+    test.server.OutputLimits(4096, 16 * 1024, std::chrono::seconds(1));
+    test.Start();
+
+    // the output of the command exceeds the limit before the end of the command:
+    // it's written afterwards, and the client gets all of it
+    Client reading(test.server.Port());
+    BOOST_REQUIRE(reading.ReadUntil("cli>"));
+    reading.Send("flood 1000\r\n");
+    BOOST_REQUIRE(reading.ReadUntil("cli>", 2));
+    BOOST_CHECK_EQUAL(Count(reading.Received(), string(99, 'x') + "\r\n"), 1000u);
+    BOOST_CHECK(reading.Received().find("end of flood\r\n") != string::npos);
+
+    // a client that doesn't read
+    // (the output exceeds what the socket buffers can hold)
+    const std::size_t nLines = 100000;
+    Client stalled(test.server.Port(), 16 * 1024);
+    BOOST_REQUIRE(stalled.ReadUntil("cli>"));
+    stalled.Send("flood " + to_string(nLines) + "\r\n");
+    this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // doesn't stall the other sessions
+    const auto start = std::chrono::steady_clock::now();
+    reading.Send("ping\r\n");
+    BOOST_CHECK(reading.ReadUntil("pong\r\n"));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+
+    // and it's dropped after the timeout
+    this_thread::sleep_for(std::chrono::seconds(2));
+    BOOST_CHECK_LT(stalled.ReadToEnd(), nLines * 100u);
+
+    reading.Send("ping\r\n");
+    BOOST_CHECK(reading.ReadUntil("pong\r\n", 2));
+}
+
+BOOST_AUTO_TEST_CASE(MaxOutput, * boost::unit_test::timeout(60))
+{
+    TestServer test(FloodMenu());
+    test.server.OutputLimits(4096, 16 * 1024, std::chrono::seconds(30), 1024 * 1024);
+    test.Start();
+
+    // the output of the command exceeds the maximum: the client is dropped
+    // without waiting for the timeout
+    const std::size_t nLines = 100000;
+    Client flooded(test.server.Port(), 16 * 1024);
+    BOOST_REQUIRE(flooded.ReadUntil("cli>"));
+    const auto start = std::chrono::steady_clock::now();
+    flooded.Send("flood " + to_string(nLines) + "\r\n");
+    this_thread::sleep_for(std::chrono::milliseconds(500));
+    BOOST_CHECK_LT(flooded.ReadToEnd(), nLines * 100u);
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include "cli/detail/telnettrace.h"
+
+using namespace std;
+using namespace cli::detail;
+
+BOOST_AUTO_TEST_SUITE(TelnetTraceSuite)
+
+BOOST_AUTO_TEST_CASE(Dump)
+{
+    TelnetTrace trace(10);
+    const auto s1 = trace.NewSession();
+    const auto s2 = trace.NewSession();
+    BOOST_CHECK(s1 != s2);
+
+    stringstream oss;
+    trace.Dump(oss);
+    BOOST_CHECK_EQUAL(oss.str(), "");
+
+    trace.Record(s1, TelnetTrace::Event::will, '\x1F');
+    trace.Record(s2, TelnetTrace::Event::command, '\xFD');
+    trace.Dump(oss);
+    BOOST_CHECK_EQUAL(oss.str(),
+        "session " + to_string(s1) + ": will 31\n"
+        "session " + to_string(s2) + ": command 253\n"
+    );
+
+    trace.Clear();
+    oss.str("");
+    trace.Dump(oss);
+    BOOST_CHECK_EQUAL(oss.str(), "");
+}
+
+BOOST_AUTO_TEST_CASE(Overwrite)
+{
+    TelnetTrace trace(3);
+    for (char c = 'a'; c <= 'e'; ++c)
+        trace.Record(1, TelnetTrace::Event::data, c);
+
+    stringstream oss;
+    trace.Dump(oss);
+    // only the last 3 events are kept
+    BOOST_CHECK_EQUAL(oss.str(),
+        "session 1: data 99\n"
+        "session 1: data 100\n"
+        "session 1: data 101\n"
+    );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
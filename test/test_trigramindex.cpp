@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * CLI - A simple command line interface.
+ * Copyright (C) 2016-2024 Daniele Pallastrelli
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include "cli/detail/trigramindex.h"
+
+using namespace std;
+using namespace cli::detail;
+
+BOOST_AUTO_TEST_SUITE(TrigramIndexSuite)
+
+BOOST_AUTO_TEST_CASE(Basics)
+{
+    const vector<string> v = { "show interfaces", "set speed 100", "show version", "reset", "sh" };
+    const auto entry = [&](size_t i){ return make_pair(v[i].data(), v[i].size()); };
+    const TrigramIndex index(v.size(), entry);
+
+    BOOST_CHECK(index.Find("show", v.size(), entry) == 2);
+    BOOST_CHECK(index.Find("show", 2, entry) == 0);
+    BOOST_CHECK(index.Find("show", 0, entry) == TrigramIndex::npos);
+    BOOST_CHECK(index.Find("set", v.size(), entry) == 3);
+    BOOST_CHECK(index.Find("speed 100", v.size(), entry) == 1);
+    BOOST_CHECK(index.Find("speed 1000", v.size(), entry) == TrigramIndex::npos);
+    BOOST_CHECK(index.Find("xyz", v.size(), entry) == TrigramIndex::npos);
+    // shorter than a trigram
+    BOOST_CHECK(index.Find("sh", v.size(), entry) == 4);
+    BOOST_CHECK(index.Find("", v.size(), entry) == 4);
+    BOOST_CHECK(index.Find("v", v.size(), entry) == 2);
+    BOOST_CHECK(index.Find("v", 2, entry) == TrigramIndex::npos);
+    BOOST_CHECK(index.Find("z", v.size(), entry) == TrigramIndex::npos);
+    BOOST_CHECK(index.Find("hw", v.size(), entry) == TrigramIndex::npos);
+}
+
+BOOST_AUTO_TEST_CASE(Random)
+{
+    // the index gives the same results of a scan
+    mt19937 gen(42);
+    uniform_int_distribution<int> letter('a', 'e');
+    uniform_int_distribution<size_t> length(0, 12);
+    vector<string> v(2000);
+    for (auto& s: v)
+        for (size_t n = length(gen); n > 0; --n)
+            s += static_cast<char>(letter(gen));
+    const auto entry = [&](size_t i){ return make_pair(v[i].data(), v[i].size()); };
+    const TrigramIndex index(v.size(), entry);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        string text;
+        for (size_t n = length(gen) / 2; n > 0; --n)
+            text += static_cast<char>(letter(gen));
+        const size_t before = uniform_int_distribution<size_t>(0, v.size())(gen);
+        BOOST_CHECK(index.Find(text, before, entry) == TrigramIndex::Scan(text, before, entry));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
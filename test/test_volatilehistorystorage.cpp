@@ -56,4 +56,26 @@ BOOST_AUTO_TEST_CASE(Basics)
     BOOST_CHECK(s.Commands().empty()); // check clear
 }
 
+BOOST_AUTO_TEST_CASE(SharedSnapshot)
+{
+    VolatileHistoryStorage s(10);
+    s.Store({ "item1", "item2" });
+
+    // the sessions share the same snapshot until the next store
+    auto snapshot = s.Snapshot();
+    BOOST_CHECK_EQUAL(snapshot, s.Snapshot());
+    BOOST_CHECK_EQUAL(snapshot->Size(), 2u);
+
+    s.Store({ "item3" });
+    auto snapshot2 = s.Snapshot();
+    BOOST_CHECK_NE(snapshot, snapshot2);
+    BOOST_CHECK_EQUAL(snapshot2->Size(), 3u);
+    BOOST_CHECK_EQUAL(snapshot2->At(2), "item3");
+    BOOST_CHECK_EQUAL(snapshot->Size(), 2u); // the old one doesn't change
+
+    s.Clear();
+    BOOST_CHECK_EQUAL(s.Snapshot()->Size(), 0u);
+    BOOST_CHECK_EQUAL(snapshot2->Size(), 3u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file